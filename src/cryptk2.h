@@ -1,71 +1,146 @@
-/**
- *  CryptK2 Library - KCipher-2(R) Implementation for C/C++
- *  Copyright (c) 2015-2022 Mystia.org Project. All rights reserved.
- */
-
-#ifndef LIBCRYPTK2_CRYPTK2_H_
-#define LIBCRYPTK2_CRYPTK2_H_
-
-// for size_t
-#include <stddef.h>
-// for uint8_t
-#include <stdint.h>
-
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-
-// we always use dll in this version
-//#ifndef CRYPTK2_DLL
-//#  define CRYPTK2_DLL
-//#endif
-
-
-#ifdef _WIN32
-#  ifdef CRYPTK2_DLL
-#    ifdef CRYPTK2_INTERNAL
-#      define CRYPTK2_API __stdcall
-#    else
-#      define CRYPTK2_API __declspec(dllimport) __stdcall
-#    endif
-#  endif
-#elif __GNUC__ >= 4
-#  define CRYPTK2_API __attribute__ ((visibility ("default")))
-#  define CRYPTK2_LOCAL __attribute__ ((visibility ("hidden")))
-#endif
-#ifndef CRYPTK2_API
-#  define CRYPTK2_API
-#endif
-#ifndef CRYPTK2_LOCAL
-#  define CRYPTK2_LOCAL
-#endif
-
-
-// ensure the backward compatibility
-#define KCIPHER2 CRYPTK2
-#define new_kcipher2 new_cryptk2
-#define kcipher2_setup cryptk2_setup
-#define kcipher2_crypt cryptk2_crypt
-#define kcipher2_decrypt cryptk2_crypt
-#define kcipher2_encrypt cryptk2_crypt
-#define kcipher2_stream cryptk2_stream
-#define delete_kcipher2 delete_cryptk2
-#define cryptk2_decrypt cryptk2_crypt
-#define cryptk2_encrypt cryptk2_crypt
-
-
-typedef struct _cryptk2 *CRYPTK2;
-
-CRYPTK2 CRYPTK2_API new_cryptk2(void);
-void CRYPTK2_API cryptk2_setup(CRYPTK2 state, const uint8_t *key, const uint8_t *iv);
-void CRYPTK2_API cryptk2_crypt(CRYPTK2 state, size_t len, const uint8_t *in, uint8_t *out);
-void CRYPTK2_API cryptk2_stream(CRYPTK2 state, size_t len, uint8_t *out);
-void CRYPTK2_API delete_cryptk2(CRYPTK2 state);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif
+/**
+ *  CryptK2 Library - KCipher-2(R) Implementation for C/C++
+ *  Copyright (c) 2015-2022 Mystia.org Project. All rights reserved.
+ */
+
+#ifndef LIBCRYPTK2_CRYPTK2_H_
+#define LIBCRYPTK2_CRYPTK2_H_
+
+// for size_t
+#include <stddef.h>
+// for uint8_t
+#include <stdint.h>
+// for struct iovec
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// we always use dll in this version
+//#ifndef CRYPTK2_DLL
+//#  define CRYPTK2_DLL
+//#endif
+
+
+// windows has no struct iovec (define CRYPTK2_HAVE_IOVEC if another header brings it)
+#if defined(_WIN32) && !defined(CRYPTK2_HAVE_IOVEC)
+#define CRYPTK2_HAVE_IOVEC
+struct iovec {
+	void *iov_base;
+	size_t iov_len;
+};
+#endif
+
+
+#ifdef _WIN32
+#  ifdef CRYPTK2_DLL
+#    ifdef CRYPTK2_INTERNAL
+#      define CRYPTK2_API __stdcall
+#    else
+#      define CRYPTK2_API __declspec(dllimport) __stdcall
+#    endif
+#  endif
+#elif __GNUC__ >= 4
+#  define CRYPTK2_API __attribute__ ((visibility ("default")))
+#  define CRYPTK2_LOCAL __attribute__ ((visibility ("hidden")))
+#endif
+#ifndef CRYPTK2_API
+#  define CRYPTK2_API
+#endif
+#ifndef CRYPTK2_LOCAL
+#  define CRYPTK2_LOCAL
+#endif
+
+
+// ensure the backward compatibility
+#define KCIPHER2 CRYPTK2
+#define new_kcipher2 new_cryptk2
+#define kcipher2_setup cryptk2_setup
+#define kcipher2_crypt cryptk2_crypt
+#define kcipher2_decrypt cryptk2_crypt
+#define kcipher2_encrypt cryptk2_crypt
+#define kcipher2_stream cryptk2_stream
+#define delete_kcipher2 delete_cryptk2
+#define cryptk2_decrypt cryptk2_crypt
+#define cryptk2_encrypt cryptk2_crypt
+
+
+typedef struct _cryptk2 *CRYPTK2;
+typedef struct _cryptk2_key *CRYPTK2_KEY;
+typedef struct _cryptk2_pool *CRYPTK2_POOL;
+typedef struct _cryptk2_table *CRYPTK2_TABLE;
+typedef uint32_t CRYPTK2_HANDLE;
+typedef struct _cryptk2_job {
+	CRYPTK2_HANDLE handle;
+	size_t len;
+	const uint8_t *in;
+	uint8_t *out;
+} CRYPTK2_JOB;
+
+// bytes of an exported state
+#define CRYPTK2_EXPORT_SIZE 156
+
+#define CRYPTK2_INVALID_HANDLE ((CRYPTK2_HANDLE)0xffffffffu)
+typedef const char *CRYPTK2_STRING;
+
+CRYPTK2 CRYPTK2_API new_cryptk2(void);
+void CRYPTK2_API cryptk2_setup(CRYPTK2 state, const uint8_t *key, const uint8_t *iv);
+void CRYPTK2_API cryptk2_crypt(CRYPTK2 state, size_t len, const uint8_t *in, uint8_t *out);
+void CRYPTK2_API cryptk2_stream(CRYPTK2 state, size_t len, uint8_t *out);
+void CRYPTK2_API cryptk2_skip(CRYPTK2 state, uint64_t len);
+size_t CRYPTK2_API cryptk2_cryptv(CRYPTK2 state, const struct iovec *in, int n_in, const struct iovec *out, int n_out);
+void CRYPTK2_API cryptk2_crypt_lanes(CRYPTK2 *states, size_t n, size_t len, const uint8_t *const *in, uint8_t *const *out);
+void CRYPTK2_API cryptk2_recrypt(CRYPTK2 from, CRYPTK2 to, size_t len, const uint8_t *in, uint8_t *out);
+void CRYPTK2_API delete_cryptk2(CRYPTK2 state);
+
+// copies and checkpoints of a stream. the exported form holds unused stream, so keep it as secret as the key.
+CRYPTK2 CRYPTK2_API cryptk2_clone(CRYPTK2 state);
+size_t CRYPTK2_API cryptk2_export(CRYPTK2 state, uint8_t *buf);
+CRYPTK2 CRYPTK2_API cryptk2_import(const uint8_t *buf);
+
+// states in memory of the caller (stack, structs or arenas): cryptk2_state_size bytes aligned to
+// cryptk2_state_align. cryptk2_clear wipes such a state instead of delete_cryptk2.
+// new_cryptk2 still allocates each state; these and the pool below avoid a malloc per stream.
+size_t CRYPTK2_API cryptk2_state_size(void);
+size_t CRYPTK2_API cryptk2_state_align(void);
+CRYPTK2 CRYPTK2_API cryptk2_init_at(void *mem);
+void CRYPTK2_API cryptk2_clear(CRYPTK2 state);
+
+// pool of states, safe to share by threads. cryptk2_pool_delete frees the states not yet put back, too.
+CRYPTK2_POOL CRYPTK2_API cryptk2_pool_new(size_t count);
+CRYPTK2 CRYPTK2_API cryptk2_pool_get(CRYPTK2_POOL pool);
+void CRYPTK2_API cryptk2_pool_put(CRYPTK2_POOL pool, CRYPTK2 state);
+void CRYPTK2_API cryptk2_pool_delete(CRYPTK2_POOL pool);
+
+// table of sessions: 81 bytes per session, addressed by handles. not safe to share by threads.
+CRYPTK2_TABLE CRYPTK2_API cryptk2_table_new(size_t capacity);
+CRYPTK2_HANDLE CRYPTK2_API cryptk2_table_open(CRYPTK2_TABLE table, CRYPTK2_KEY keyctx, const uint8_t *iv);
+void CRYPTK2_API cryptk2_table_close(CRYPTK2_TABLE table, CRYPTK2_HANDLE handle);
+void CRYPTK2_API cryptk2_table_crypt(CRYPTK2_TABLE table, CRYPTK2_HANDLE handle, size_t len, const uint8_t *in, uint8_t *out);
+void CRYPTK2_API cryptk2_table_crypt_batch(CRYPTK2_TABLE table, const CRYPTK2_JOB *jobs, size_t n);
+void CRYPTK2_API cryptk2_table_delete(CRYPTK2_TABLE table);
+
+// expanded key, shared read-only by any number of states (and threads)
+CRYPTK2_KEY CRYPTK2_API cryptk2_key_new(void);
+void CRYPTK2_API cryptk2_key_expand(CRYPTK2_KEY keyctx, const uint8_t *key);
+void CRYPTK2_API cryptk2_setup_iv(CRYPTK2 state, CRYPTK2_KEY keyctx, const uint8_t *iv);
+void CRYPTK2_API cryptk2_setup_batch(CRYPTK2_KEY keyctx, size_t n, const uint8_t *const *ivs, CRYPTK2 *states);
+void CRYPTK2_API cryptk2_setup_keys(const CRYPTK2_KEY *keyctxs, size_t n, const uint8_t *const *ivs, CRYPTK2 *states);
+void CRYPTK2_API cryptk2_key_delete(CRYPTK2_KEY keyctx);
+
+// kernel selection: "auto", "portable" or a comma-separated list of "sse2", "aesni", "avx2", "avx512".
+// the environment variable CRYPTK2_BACKEND takes the same names, but an unknown or unsupported one there
+// is ignored (the best kernels are bound), so check cryptk2_get_backend to see what is in use.
+int CRYPTK2_API cryptk2_set_backend(const char *name);
+CRYPTK2_STRING CRYPTK2_API cryptk2_get_backend(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ *  CryptK2 Library - KCipher-2(R) Implementation for C/C++
+ *  Copyright (c) 2015-2022 Mystia.org Project. All rights reserved.
+ */
+
+// single-stream kernel template, included from cryptk2.c once per backend.
+// the includer defines the following before including:
+//
+//   KERNEL_NAME(name)     decorates function names with the backend
+//   KERNEL_TARGET         function attribute which enables the instruction set
+//   KERNEL_SUB4(x0, x1, x2, x3, y0, y1, y2, y3)
+//                         y0 = sub(x0), ..., y3 = sub(x3)
+
+
+#define BEGIN_CASE if (0);
+#define CASE_SETUPMODE if (mode == MODE_SETUP)
+#define CASE_UPDATEMODE if (mode == MODE_UPDATE)
+#define END_CASE else;
+
+// update to the next state
+static inline KERNEL_TARGET void KERNEL_NAME(update_internal)(CRYPTK2 state, const enum mode_update mode) {
+	uint32_t a, b;
+	uint32_t l1, r1, l2, r2;
+	uint32_t temp1, temp2;
+
+	KERNEL_SUB4(state->l2 + state->b[9], state->r1, state->r2 + state->b[4], state->l1, r1, r2, l1, l2);
+
+	// shift register
+	a = state->a[0];
+	state->a[0] = state->a[1];
+	state->a[1] = state->a[2];
+	state->a[2] = state->a[3];
+	state->a[3] = state->a[4];
+	b = state->b[0];
+	state->b[0] = state->b[1];
+	state->b[1] = state->b[2];
+	state->b[2] = state->b[3];
+	state->b[3] = state->b[4];
+	state->b[4] = state->b[5];
+	state->b[5] = state->b[6];
+	state->b[6] = state->b[7];
+	state->b[7] = state->b[8];
+	state->b[8] = state->b[9];
+	state->b[9] = state->b[10];
+
+	// update state->a[4]
+	temp1 = mul_a0(a);
+
+	BEGIN_CASE
+	CASE_SETUPMODE  { state->a[4] = temp1 ^ state->a[2] ^ nlf(b, state->r2, state->r1, state->a[4]); }
+	CASE_UPDATEMODE { state->a[4] = temp1 ^ state->a[2]; }
+	END_CASE
+
+	// update state->b[10]
+	if (state->a[1] & 0x40000000) {
+		temp1 = mul_a1(b);
+	}
+	else {
+		temp1 = mul_a2(b);
+	}
+
+	if (state->a[1] & 0x80000000) {
+		temp2 = mul_a3(state->b[7]);
+	}
+	else {
+		temp2 = state->b[7];
+	}
+
+	BEGIN_CASE
+	CASE_SETUPMODE  { state->b[10] = temp1 ^ state->b[0] ^ state->b[5] ^ temp2 ^ nlf(state->b[10], state->l2, state->l1, a); }
+	CASE_UPDATEMODE { state->b[10] = temp1 ^ state->b[0] ^ state->b[5] ^ temp2; }
+	END_CASE
+
+	// copy internal registers
+	state->r1 = r1;
+	state->r2 = r2;
+	state->l1 = l1;
+	state->l2 = l2;
+
+	BEGIN_CASE
+	CASE_UPDATEMODE { gen_stream(state); }
+	END_CASE
+}
+
+// run the 24 initialization rounds
+static KERNEL_TARGET void KERNEL_NAME(setup_rounds)(CRYPTK2 state) {
+	for (int i=0; i<24; ++i) {
+		KERNEL_NAME(update_internal)(state, MODE_SETUP);
+	}
+}
+
+// run the 24 initialization rounds of SETUP_WAYS states, interleaved for instruction-level parallelism
+static KERNEL_TARGET void KERNEL_NAME(setup_rounds_x4)(CRYPTK2 *states) {
+	CRYPTK2 s0 = states[0], s1 = states[1], s2 = states[2], s3 = states[3];
+
+	for (int i=0; i<24; ++i) {
+		KERNEL_NAME(update_internal)(s0, MODE_SETUP);
+		KERNEL_NAME(update_internal)(s1, MODE_SETUP);
+		KERNEL_NAME(update_internal)(s2, MODE_SETUP);
+		KERNEL_NAME(update_internal)(s3, MODE_SETUP);
+	}
+}
+
+#undef BEGIN_CASE
+#undef CASE_SETUPMODE
+#undef CASE_UPDATEMODE
+#undef END_CASE
+
+
+#define BEGIN_CASE if (0);
+#define CASE_CRYPTMODE else if (mode == MODE_CRYPT)
+#define CASE_STREAMMODE else if (mode == MODE_STREAM)
+#define CASE_SKIPMODE else if (mode == MODE_SKIP)
+#define END_CASE else;
+
+// one update on local registers, with the output of the current block (none when skipping). the shift
+// registers never move: the new a[4] and b[10] take the places of the dropped a[0]
+// and b[0], and the caller rotates the names for the next step.
+#define KERNEL_STEP(a0, a1, a2, a3, a4, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10) { \
+	BEGIN_CASE \
+	CASE_CRYPTMODE  { store_uint64(out, load_uint64(in) ^ (((uint64_t)nlf(b10, l2, l1, a0) << 32) | nlf(b0, r2, r1, a4))); in += 8; out += 8; } \
+	CASE_STREAMMODE { store_uint64(out, ((uint64_t)nlf(b10, l2, l1, a0) << 32) | nlf(b0, r2, r1, a4)); out += 8; } \
+	CASE_SKIPMODE   { } \
+	END_CASE \
+	KERNEL_SUB4(l2 + b9, r1, r2 + b4, l1, nr1, nr2, nl1, nl2); \
+	m1 = 0u - ((a2 >> 30) & 1); \
+	m3 = 0u - (a2 >> 31); \
+	a0 = mul_a0(a0) ^ a3; \
+	b0 = (mul_a1(b0) & m1) ^ (mul_a2(b0) & ~m1) ^ b1 ^ b6 ^ b8 ^ ((mul_a3(b8) ^ b8) & m3); \
+	r1 = nr1; \
+	r2 = nr2; \
+	l1 = nl1; \
+	l2 = nl2; \
+}
+
+// output encrypted data or raw stream for whole blocks, or only move past them (the state must stand at the beginning of a block).
+// the state is kept in locals and stored back once, so out may alias the state.
+static inline KERNEL_TARGET void KERNEL_NAME(blocks_internal)(CRYPTK2 state, const enum mode_crypt mode, size_t blocks, const uint8_t *in, uint8_t *out) {
+	uint32_t a0, a1, a2, a3, a4;
+	uint32_t b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10;
+	uint32_t r1, r2, l1, l2, nr1, nr2, nl1, nl2;
+	uint32_t m1, m3, temp;
+
+	if (blocks == 0) {
+		return;
+	}
+
+	// load internal state
+	a0 = state->a[0]; a1 = state->a[1]; a2 = state->a[2]; a3 = state->a[3]; a4 = state->a[4];
+	b0 = state->b[0]; b1 = state->b[1]; b2 = state->b[2]; b3 = state->b[3]; b4 = state->b[4]; b5 = state->b[5];
+	b6 = state->b[6]; b7 = state->b[7]; b8 = state->b[8]; b9 = state->b[9]; b10 = state->b[10];
+	r1 = state->r1; r2 = state->r2; l1 = state->l1; l2 = state->l2;
+
+	// 55 blocks bring both shift registers (5 and 11 words) back to the same names
+	for (; blocks>=55; blocks-=55) {
+		KERNEL_STEP(a0, a1, a2, a3, a4, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b2, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b3, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b4, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b5, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4);
+		KERNEL_STEP(a0, a1, a2, a3, a4, b6, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5);
+		KERNEL_STEP(a1, a2, a3, a4, a0, b7, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6);
+		KERNEL_STEP(a2, a3, a4, a0, a1, b8, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7);
+		KERNEL_STEP(a3, a4, a0, a1, a2, b9, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8);
+		KERNEL_STEP(a4, a0, a1, a2, a3, b10, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9);
+	}
+
+	// the rest, rotating the values instead of the names
+	for (; blocks!=0; --blocks) {
+		KERNEL_STEP(a0, a1, a2, a3, a4, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10);
+		temp = a0; a0 = a1; a1 = a2; a2 = a3; a3 = a4; a4 = temp;
+		temp = b0; b0 = b1; b1 = b2; b2 = b3; b3 = b4; b4 = b5; b5 = b6; b6 = b7; b7 = b8; b8 = b9; b9 = b10; b10 = temp;
+	}
+
+	// store internal state
+	state->a[0] = a0; state->a[1] = a1; state->a[2] = a2; state->a[3] = a3; state->a[4] = a4;
+	state->b[0] = b0; state->b[1] = b1; state->b[2] = b2; state->b[3] = b3; state->b[4] = b4; state->b[5] = b5;
+	state->b[6] = b6; state->b[7] = b7; state->b[8] = b8; state->b[9] = b9; state->b[10] = b10;
+	state->r1 = r1; state->r2 = r2; state->l1 = l1; state->l2 = l2;
+	gen_stream(state);
+}
+
+#undef KERNEL_STEP
+static KERNEL_TARGET void KERNEL_NAME(crypt_blocks)(CRYPTK2 state, size_t blocks, const uint8_t *in, uint8_t *out) {
+	KERNEL_NAME(blocks_internal)(state, MODE_CRYPT, blocks, in, out);
+}
+static KERNEL_TARGET void KERNEL_NAME(stream_blocks)(CRYPTK2 state, size_t blocks, uint8_t *out) {
+	KERNEL_NAME(blocks_internal)(state, MODE_STREAM, blocks, NULL, out);
+}
+static KERNEL_TARGET void KERNEL_NAME(skip_blocks)(CRYPTK2 state, size_t blocks) {
+	KERNEL_NAME(blocks_internal)(state, MODE_SKIP, blocks, NULL, NULL);
+}
+
+#undef BEGIN_CASE
+#undef CASE_CRYPTMODE
+#undef CASE_STREAMMODE
+#undef CASE_SKIPMODE
+#undef END_CASE
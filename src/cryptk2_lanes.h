@@ -0,0 +1,187 @@
+/**
+ *  CryptK2 Library - KCipher-2(R) Implementation for C/C++
+ *  Copyright (c) 2015-2022 Mystia.org Project. All rights reserved.
+ */
+
+// multi-lane kernel template, included from cryptk2.c once per instruction set.
+// it runs LANES independent streams in structure-of-arrays form, one stream per
+// 32-bit element.  the includer defines the following before including:
+//
+//   LANES                 number of 32-bit elements in one vector
+//   LANES_NAME(name)      decorates function names with the instruction set
+//   LANES_TARGET          function attribute which enables the instruction set
+//   lanes_vec_t           vector type
+//   lanes_mask_t          per-lane boolean type
+//   V_LOAD(p), V_STORE(p, v), V_SET1(u)
+//   V_ADD(x, y), V_XOR(x, y), V_AND(x, y), V_SLLI(v, n), V_SRLI(v, n)
+//   V_GATHER(table, index)
+//   V_MASK_GATHER(src, table, index, mask)   lanes not in mask keep src
+//   V_TEST(v, bit)        lanes of v which have the bit set
+//   V_MASK_NOT(mask)
+//   V_BLEND(mask, x, y)   x where mask is set, y elsewhere
+//
+// LANES_NO_SETUP leaves out setup_lanes where the scalar kernels are faster.
+
+
+// do substitution
+#define L_SUB(u) \
+	V_XOR(V_XOR(V_GATHER(ts0, V_AND((u), l_ff)), V_GATHER(ts1, V_AND(V_SRLI((u), 8), l_ff))), \
+	      V_XOR(V_GATHER(ts2, V_AND(V_SRLI((u), 16), l_ff)), V_GATHER(ts3, V_SRLI((u), 24))))
+
+// do multiplicative operation with alpha_0[256]
+#define L_MUL_A0(u) V_XOR(V_SLLI((u), 8), V_GATHER(ta0, V_SRLI((u), 24)))
+
+// non-linear function
+#define L_NLF(a, b, c, d) V_XOR(V_XOR(V_ADD((a), (b)), (c)), (d))
+
+
+// update all lanes to the next state (setup adds the initialization terms)
+#define L_UPDATE(setup) { \
+	nr1 = L_SUB(V_ADD(l2, b[9])); \
+	nr2 = L_SUB(r1); \
+	nl1 = L_SUB(V_ADD(r2, b[4])); \
+	nl2 = L_SUB(l1); \
+	\
+	/* shift register (a[4] and b[10] keep their old values until replaced) */ \
+	oa = a[0]; \
+	for (j=0; j<4; ++j) { \
+		a[j] = a[j + 1]; \
+	} \
+	ob = b[0]; \
+	for (j=0; j<10; ++j) { \
+		b[j] = b[j + 1]; \
+	} \
+	\
+	/* update a[4] */ \
+	temp1 = V_XOR(L_MUL_A0(oa), a[2]); \
+	if (setup) { \
+		temp1 = V_XOR(temp1, L_NLF(ob, r2, r1, a[4])); \
+	} \
+	a[4] = temp1; \
+	\
+	/* update b[10]: alpha_1 or alpha_2 depending on a[1], then alpha_3 or nothing */ \
+	m = V_TEST(a[1], 0x40000000u); \
+	temp1 = V_MASK_GATHER(V_SET1(0), ta1, V_SRLI(ob, 24), m); \
+	temp1 = V_MASK_GATHER(temp1, ta2, V_SRLI(ob, 24), V_MASK_NOT(m)); \
+	temp1 = V_XOR(V_SLLI(ob, 8), temp1); \
+	\
+	m = V_TEST(a[1], 0x80000000u); \
+	temp2 = V_MASK_GATHER(V_SET1(0), ta3, V_SRLI(b[7], 24), m); \
+	temp2 = V_BLEND(m, V_XOR(V_SLLI(b[7], 8), temp2), b[7]); \
+	\
+	temp1 = V_XOR(V_XOR(temp1, b[0]), V_XOR(b[5], temp2)); \
+	if (setup) { \
+		temp1 = V_XOR(temp1, L_NLF(b[10], l2, l1, oa)); \
+	} \
+	b[10] = temp1; \
+	\
+	r1 = nr1; \
+	r2 = nr2; \
+	l1 = nl1; \
+	l2 = nl2; \
+}
+
+// move LANES states into registers
+#define L_LOAD_STATE(field) \
+	for (l=0; l<LANES; ++l) { lane[l] = states[l]->field; } \
+	v = V_LOAD(lane);
+
+// move registers back into LANES states
+#define L_STORE_STATE(field, v) \
+	V_STORE(lane, (v)); \
+	for (l=0; l<LANES; ++l) { states[l]->field = lane[l]; }
+
+// all registers of LANES states
+#define L_LOAD_STATES() \
+	for (j=0; j<5; ++j) { \
+		L_LOAD_STATE(a[j]); \
+		a[j] = v; \
+	} \
+	for (j=0; j<11; ++j) { \
+		L_LOAD_STATE(b[j]); \
+		b[j] = v; \
+	} \
+	L_LOAD_STATE(r1); r1 = v; \
+	L_LOAD_STATE(r2); r2 = v; \
+	L_LOAD_STATE(l1); l1 = v; \
+	L_LOAD_STATE(l2); l2 = v;
+
+// all registers and the next stream of LANES states
+#define L_STORE_STATES() \
+	for (j=0; j<5; ++j) { \
+		L_STORE_STATE(a[j], a[j]); \
+	} \
+	for (j=0; j<11; ++j) { \
+		L_STORE_STATE(b[j], b[j]); \
+	} \
+	L_STORE_STATE(r1, r1); \
+	L_STORE_STATE(r2, r2); \
+	L_STORE_STATE(l1, l1); \
+	L_STORE_STATE(l2, l2); \
+	L_STORE_STATE(sh, L_NLF(b[10], l2, l1, a[0])); \
+	L_STORE_STATE(sl, L_NLF(b[0], r2, r1, a[4]));
+
+
+// output encrypted data of LANES streams for the given number of whole blocks.
+// every state must have an empty stream buffer.
+static LANES_TARGET void LANES_NAME(crypt_lanes)(CRYPTK2 *states, size_t blocks, const uint8_t *const *in, uint8_t *const *out) {
+	lanes_vec_t a[5], b[11], r1, r2, l1, l2;
+	lanes_vec_t v, nr1, nr2, nl1, nl2, oa, ob, temp1, temp2;
+	lanes_vec_t l_ff = V_SET1(0xff);
+	lanes_mask_t m;
+	uint32_t lane[LANES], sh[LANES], sl[LANES];
+	size_t i, pos;
+	int j, l;
+
+	// load internal states
+	L_LOAD_STATES();
+
+	for (i=0, pos=0; i<blocks; ++i, pos+=8) {
+		// generate pseudo-random number stream and output
+		V_STORE(sh, L_NLF(b[10], l2, l1, a[0]));
+		V_STORE(sl, L_NLF(b[0], r2, r1, a[4]));
+		for (l=0; l<LANES; ++l) {
+			store_uint64(out[l] + pos, load_uint64(in[l] + pos) ^ (((uint64_t)sh[l] << 32) | sl[l]));
+		}
+
+		// update internal registers
+		L_UPDATE(0);
+	}
+
+	// store internal states and the next stream
+	L_STORE_STATES();
+}
+
+
+#ifndef LANES_NO_SETUP
+// run the 24 initialization rounds of LANES states and set their next stream.
+static LANES_TARGET void LANES_NAME(setup_lanes)(CRYPTK2 *states) {
+	lanes_vec_t a[5], b[11], r1, r2, l1, l2;
+	lanes_vec_t v, nr1, nr2, nl1, nl2, oa, ob, temp1, temp2;
+	lanes_vec_t l_ff = V_SET1(0xff);
+	lanes_mask_t m;
+	uint32_t lane[LANES];
+	int i, j, l;
+
+	// load internal states
+	L_LOAD_STATES();
+
+	// update 24 times
+	for (i=0; i<24; ++i) {
+		L_UPDATE(1);
+	}
+
+	// store internal states and the next stream
+	L_STORE_STATES();
+}
+#endif
+
+
+#undef L_SUB
+#undef L_MUL_A0
+#undef L_NLF
+#undef L_UPDATE
+#undef L_LOAD_STATE
+#undef L_STORE_STATE
+#undef L_LOAD_STATES
+#undef L_STORE_STATES
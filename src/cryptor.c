@@ -1,341 +1,3433 @@
-﻿/**
- * 暗号化とか復号とか、そんなの (CryptK2-Frontend 0.1.4)
- * Written by parly 2015
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdint.h>
-#include <string.h>
-#include <windows.h>
-
-
-// コンパイルには、CryptK2 Library が必要です。
-#include "cryptk2.h"
-
-
-// エラー番号
-#define ERROR_MALLOC_FAILED 1
-#define ERROR_INVALID_ARGS 2
-#define ERROR_INVALID_INFILE 3
-#define ERROR_FAILED_TO_OPEN_KEYFILE 4
-#define ERROR_FAILED_TO_OPEN_INFILE 5
-#define ERROR_FAILED_TO_OPEN_OUTFILE 6
-#define ERROR_INVALID_KEYFILE 7
-#define ERROR_FAILED_TO_GENERATE_IV 8
-
-// ファイルバッファーのサイズ
-#define BUFFER_SIZE 512000
-
-
-// モード
-typedef enum { MODE_MAKEKEY, MODE_ENCRYPT, MODE_DECRYPT } cryptmode_t;
-
-
-
-// 諸関数
-static void generate_keyiv(uint8_t *buf);
-static void make_keyfile(char *filename);
-static void read_keyfile(char *filename, uint8_t *buf);
-static void encrypt_file(char *src, char *dst, uint8_t *key);
-static void decrypt_file(char *src, char *dst, uint8_t *key);
-
-
-#ifdef FORWARD_MAIN
-#  define main _entry
-#endif
-
-
-int main(int argc, char **argv) {
-	cryptmode_t mode;
-	uint8_t key[16];
-	int correct_argc;
-
-	// 引数が 2 個より少ない場合は処理を継続できない
-	if (argc < 2) {
-arg_error:
-		fprintf(stderr,
-			"usage:\n"
-			"\tcryptk2 -m outfile\n"
-			"\tcryptk2 -d keyfile infile outfile\n"
-			"\tcryptk2 -e keyfile infile outfile\n"
-		);
-		return ERROR_INVALID_ARGS;
-	}
-	
-	// モードは encrypt か decrypt か。
-	if (!strcmp(argv[1], "-m") || !strcmp(argv[1], "/m")) {
-		mode = MODE_MAKEKEY;
-		correct_argc = 3;
-	}
-	else if (!strcmp(argv[1], "-e") || !strcmp(argv[1], "/e")) {
-		mode = MODE_ENCRYPT;
-		correct_argc = 5;
-	}
-	else if (!strcmp(argv[1], "-d") || !strcmp(argv[1], "/d")) {
-		mode = MODE_DECRYPT;
-		correct_argc = 5;
-	}
-	else {
-		// 引数エラー
-		goto arg_error;
-	}
-
-	// 引数の数をチェック
-	if (argc != correct_argc) {
-		// 引数エラー
-		goto arg_error;
-	}
-
-	// モード別の処理
-	if (mode == MODE_MAKEKEY) {
-		// 鍵の作成
-		make_keyfile(argv[2]);
-	}
-	else {
-		// キーファイルを読み込む
-		read_keyfile(argv[2], key);
-
-		if (mode == MODE_ENCRYPT) {
-			// 暗号化
-			encrypt_file(argv[3], argv[4], key);
-		}
-		else {
-			// 復号化
-			decrypt_file(argv[3], argv[4], key);
-		}
-	}
-
-	// 正常終了
-	return 0;
-}
-
-
-// 16 バイトの暗号鍵 / IV をつくる (Windows 専用コード)
-// POSIX 環境なら /dev/urandom から 16 バイト読みこめばいいと思います。
-static void generate_keyiv(uint8_t *buf) {
-	HCRYPTPROV hProv;
-	if (CryptAcquireContext(&hProv, NULL, NULL, PROV_RSA_FULL, 0) == FALSE || CryptGenRandom(hProv, 16, (BYTE *)buf) == FALSE) {
-		fprintf(stderr, "error: failed to generate key\n");
-		exit(ERROR_FAILED_TO_GENERATE_IV);
-	}
-	CryptReleaseContext(hProv, 0);
-}
-
-
-// キーファイルをつくる
-static void make_keyfile(char *filename) {
-	FILE *f;
-	uint8_t key[16];
-
-	// キーファイルを開く
-	if ((f = fopen(filename, "wb")) == NULL) {
-		fprintf(stderr, "error: failed to open outfile\n");
-		exit(ERROR_FAILED_TO_OPEN_OUTFILE);
-	}
-
-	// キーの作成
-	generate_keyiv(key);
-
-	// キーファイルに書き込み
-	fwrite(key, sizeof(uint8_t), 16, f);
-
-	// キーファイルを閉じる
-	fclose(f);
-}
-
-
-// キーファイルを読み込む
-static void read_keyfile(char *filename, uint8_t *buf) {
-	FILE *f;
-
-	// キーファイルを開く
-	if ((f = fopen(filename, "rb")) == NULL) {
-		fprintf(stderr, "error: failed to open keyfile\n");
-		exit(ERROR_FAILED_TO_OPEN_KEYFILE);
-	}
-
-	// キーファイルは 16 バイトでなければならない
-	fseek(f, 0, SEEK_END);
-	if (ftell(f) != 16) {
-		fprintf(stderr, "error: invalid keyfile\n");
-		fclose(f);
-		exit(ERROR_INVALID_KEYFILE);
-	}
-
-	// キーファイルの読み込み
-	fseek(f, 0, SEEK_SET);
-	fread(buf, sizeof(uint8_t), 16, f);
-
-	// キーファイルを閉じる
-	fclose(f);
-}
-
-
-// ファイルを暗号化
-static void encrypt_file(char *src, char *dst, uint8_t *key) {
-	FILE *in=NULL, *out=NULL;
-	unsigned int i, loop, last, err=0;
-	fpos_t size;
-	uint8_t iv[16], inbuf[BUFFER_SIZE], outbuf[BUFFER_SIZE];
-	CRYPTK2 k2;
-
-	// 入力元ファイルを開く
-	if ((in = fopen(src, "rb")) == NULL) {
-failed_infile:
-		fprintf(stderr, "error: failed to open infile\n");
-		err = ERROR_FAILED_TO_OPEN_INFILE;
-		goto cleanup;
-	}
-
-	// 出力先ファイルを開く
-	if ((out = fopen(dst, "wb")) == NULL) {
-		fprintf(stderr, "error: failed to open outfile\n");
-		err = ERROR_FAILED_TO_OPEN_OUTFILE;
-		goto cleanup;
-	}
-
-	// 暗号化前のファイルサイズを取得
-	fseek(in, 0, SEEK_END);
-	if (fgetpos(in, &size)) {
-		goto failed_infile;
-	}
-
-	// メインループの回数を計算
-	loop = size / BUFFER_SIZE;
-
-	// あまりのバイト数を計算
-	last = size % BUFFER_SIZE;
-
-	// 初期化ベクトルをつくる
-	generate_keyiv(iv);
-	fwrite(iv, sizeof(uint8_t), 16, out);
-
-	// 暗号ライブラリー初期化
-	k2 = new_cryptk2();
-	cryptk2_setup(k2, key, iv);
-
-	// 暗号化メインループ
-	fseek(in, 0, SEEK_SET);
-	for (i=1; i<=loop; ++i) {
-		// ファイル in から暗号化前のデータを読み込み
-		fread(inbuf, sizeof(uint8_t), BUFFER_SIZE, in);
-		// 暗号化
-		cryptk2_encrypt(k2, BUFFER_SIZE, inbuf, outbuf);
-		// ファイル out へ暗号化後のデータを書き込み
-		fwrite(outbuf, sizeof(uint8_t), BUFFER_SIZE, out);
-		// パーセント表示
-		fprintf(stderr, "\rencrypting (%3u %%) ...", i * 100 / loop);
-	}
-
-	// あまりのバイト列がある場合、処理
-	if (last != 0) {
-		// ファイル in から暗号化前のデータを読み込み
-		fread(inbuf, sizeof(uint8_t), last, in);
-		// 暗号化
-		cryptk2_encrypt(k2, last, inbuf, outbuf);
-		// ファイル out へ暗号化後のデータを書き込み
-		fwrite(outbuf, sizeof(uint8_t), last, out);
-	}
-
-	// 暗号ライブラリーお掃除
-	delete_cryptk2(k2);
-
-	// 100 パーセント表示
-	fprintf(stderr, "\rencrypting (100 %%) completed!\n");
-
-cleanup:
-	// ファイルを閉じる
-	if (in != NULL) fclose(in);
-	if (out != NULL) fclose(out);
-	if (err) exit(err);
-}
-
-
-// ファイルを復号化
-static void decrypt_file(char *src, char *dst, uint8_t *key) {
-	FILE *in=NULL, *out=NULL;
-	unsigned int i, loop, last, err=0;
-	fpos_t size;
-	uint8_t iv[16], inbuf[BUFFER_SIZE], outbuf[BUFFER_SIZE];
-	CRYPTK2 k2;
-
-	// 入力元ファイルを開く
-	if ((in = fopen(src, "rb")) == NULL) {
-failed_infile:
-		fprintf(stderr, "error: failed to open infile\n");
-		err = ERROR_FAILED_TO_OPEN_INFILE;
-		goto cleanup;
-	}
-
-	// 暗号化されたファイルのファイルサイズを取得
-	fseek(in, 0, SEEK_END);
-	if (fgetpos(in, &size)) {
-		goto failed_infile;
-	}
-
-	// 暗号化されたファイルのサイズは 16 バイト (初期化ベクトルのサイズ) 以上でないとおかしい
-	if (size < 16) {
-		fprintf(stderr, "error: invalid infile\n");
-		err = ERROR_INVALID_INFILE;
-		goto cleanup;
-	}
-
-	// サイズから初期化ベクトル分のサイズを引いておく
-	size -= 16;
-
-	// 出力先ファイルを開く
-	if ((out = fopen(dst, "wb")) == NULL) {
-		fprintf(stderr, "error: failed to open outfile\n");
-		err = ERROR_FAILED_TO_OPEN_OUTFILE;
-		goto cleanup;
-	}
-
-	// メインループの回数を計算
-	loop = size / BUFFER_SIZE;
-
-	// あまりのバイト数を計算
-	last = size % BUFFER_SIZE;
-
-	// 初期化ベクトルを読み込む
-	fseek(in, 0, SEEK_SET);
-	fread(iv, sizeof(uint8_t), 16, in);
-
-	// 暗号ライブラリー初期化
-	k2 = new_cryptk2();
-	cryptk2_setup(k2, key, iv);
-
-	// 暗号化メインループ
-	for (i=1; i<=loop; ++i) {
-		// ファイル in から復号化前のデータを読み込み
-		fread(inbuf, sizeof(uint8_t), BUFFER_SIZE, in);
-		// 復号化
-		cryptk2_decrypt(k2, BUFFER_SIZE, inbuf, outbuf);
-		// ファイル out へ復号化後のデータを書き込み
-		fwrite(outbuf, sizeof(uint8_t), BUFFER_SIZE, out);
-		// パーセント表示
-		fprintf(stderr, "\rdecrypting (%3u %%) ...", i * 100 / loop);
-	}
-
-	// あまりのバイト列がある場合、処理
-	if (last != 0) {
-		// ファイル in から復号化前のデータを読み込み
-		fread(inbuf, sizeof(uint8_t), last, in);
-		// 復号化
-		cryptk2_encrypt(k2, last, inbuf, outbuf);
-		// ファイル out へ復号化後のデータを書き込み
-		fwrite(outbuf, sizeof(uint8_t), last, out);
-	}
-
-	// 暗号ライブラリーお掃除
-	delete_cryptk2(k2);
-
-	// 100 パーセント表示
-	fprintf(stderr, "\rdecrypting (100 %%) completed!\n");
-
-cleanup:
-	// ファイルを閉じる
-	if (in != NULL) fclose(in);
-	if (out != NULL) fclose(out);
-	if (err) exit(err);
-}
+﻿/**
+ * 暗号化とか復号とか、そんなの (CryptK2-Frontend 0.2.0)
+ * Written by parly 2015
+ */
+
+// Linux の fallocate と sync_file_range
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef _WIN32
+// CONDITION_VARIABLE は Vista から
+#  ifndef _WIN32_WINNT
+#    define _WIN32_WINNT 0x0600
+#  endif
+#  include <windows.h>
+#  include <io.h>
+#  include <fcntl.h>
+#  include <direct.h>
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <dirent.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  ifdef __linux__
+#    include <sys/random.h>
+#  endif
+#endif
+
+// Linux では io_uring も使える (--io-uring)。CRYPTOR_NO_IO_URING で外せる。
+#if defined(__linux__) && !defined(CRYPTOR_NO_IO_URING)
+#  define CRYPTOR_IO_URING
+#  include <sys/syscall.h>
+#  include <linux/io_uring.h>
+#endif
+
+// Linux では inotify でディレクトリを見張れる (--watch)
+#ifdef __linux__
+#  define CRYPTOR_WATCH
+#  include <signal.h>
+#  include <time.h>
+#  include <sys/inotify.h>
+#endif
+
+
+// コンパイルには、CryptK2 Library が必要です。
+#include "cryptk2.h"
+#include "cryptor_format.h"
+
+
+// エラー番号
+#define ERROR_MALLOC_FAILED 1
+#define ERROR_INVALID_ARGS 2
+#define ERROR_INVALID_INFILE 3
+#define ERROR_FAILED_TO_OPEN_KEYFILE 4
+#define ERROR_FAILED_TO_OPEN_INFILE 5
+#define ERROR_FAILED_TO_OPEN_OUTFILE 6
+#define ERROR_INVALID_KEYFILE 7
+#define ERROR_FAILED_TO_GENERATE_IV 8
+#define ERROR_FAILED_TO_CREATE_THREAD 9
+#define ERROR_FAILED_TO_READ_INFILE 10
+#define ERROR_FAILED_TO_WRITE_OUTFILE 11
+#define ERROR_CORRUPTED_INFILE 12
+#define ERROR_NOT_UPDATABLE 13
+
+// チャンクのサイズ (上限は 32 ビット)
+#define CHUNK_SIZE 1048576
+
+// スレッドの数の上限と、スレッドひとつあたりのバッファーの数 (リングの深さの既定値)
+#define MAX_THREADS 64
+#define CHUNKS_PER_THREAD 4
+
+// リングの深さの上限
+#define MAX_DEPTH 4096
+
+// バッファーはページ境界にそろえる
+#define PAGE_SIZE 4096
+
+// パスの区切り
+#ifdef _WIN32
+#  define PATH_SEPARATOR '\\'
+#  define is_separator(c) ((c) == '\\' || (c) == '/')
+#else
+#  define PATH_SEPARATOR '/'
+#  define is_separator(c) ((c) == '/')
+#endif
+
+
+// モード
+typedef enum { MODE_MAKEKEY, MODE_ENCRYPT, MODE_DECRYPT, MODE_UPDATE, MODE_ROTATE } cryptmode_t;
+
+// スレッドの仕事
+typedef enum { WORK_ENCRYPT, WORK_DECRYPT, WORK_UPDATE, WORK_RECRYPT } work_t;
+
+
+// スレッドまわり (Windows と POSIX の差を吸収する)
+#ifdef _WIN32
+typedef HANDLE thread_t;
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+#  define THREAD_PROC DWORD WINAPI
+#  define THREAD_RETURN 0
+#  define mutex_init(m) InitializeCriticalSection(m)
+#  define mutex_lock(m) EnterCriticalSection(m)
+#  define mutex_unlock(m) LeaveCriticalSection(m)
+#  define mutex_free(m) DeleteCriticalSection(m)
+#  define cond_init(c) InitializeConditionVariable(c)
+#  define cond_wait(c, m) SleepConditionVariableCS((c), (m), INFINITE)
+#  define cond_broadcast(c) WakeAllConditionVariable(c)
+#  define cond_free(c)
+#  define thread_create(t, proc, arg) ((*(t) = CreateThread(NULL, 0, (proc), (arg), 0, NULL)) != NULL)
+#  define thread_join(t) (WaitForSingleObject((t), INFINITE), CloseHandle(t))
+#  define page_free(p) _aligned_free(p)
+#  define truncate64(f, size) _chsize_s(_fileno(f), (size))
+#  define sync_file(f) _commit(_fileno(f))
+#  define replace_file(from, to) (ReplaceFileA((to), (from), NULL, 0, NULL, NULL) ? 0 : -1)
+#else
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+#  define THREAD_PROC void *
+#  define THREAD_RETURN NULL
+#  define mutex_init(m) pthread_mutex_init((m), NULL)
+#  define mutex_lock(m) pthread_mutex_lock(m)
+#  define mutex_unlock(m) pthread_mutex_unlock(m)
+#  define mutex_free(m) pthread_mutex_destroy(m)
+#  define cond_init(c) pthread_cond_init((c), NULL)
+#  define cond_wait(c, m) pthread_cond_wait((c), (m))
+#  define cond_broadcast(c) pthread_cond_broadcast(c)
+#  define cond_free(c) pthread_cond_destroy(c)
+#  define thread_create(t, proc, arg) (pthread_create((t), NULL, (proc), (arg)) == 0)
+#  define thread_join(t) pthread_join((t), NULL)
+#  define page_free(p) free(p)
+#  define truncate64(f, size) ftruncate(fileno(f), (off_t)(size))
+#  define sync_file(f) fsync(fileno(f))
+#  define replace_file(from, to) rename((from), (to))
+#endif
+
+
+// チャンクひとつぶんの仕事
+typedef struct {
+	uint64_t index;
+	size_t len;
+	uint8_t *buf;
+	const uint8_t *src; // 読むところ (マップしたとき以外は buf と同じ)
+	index_t entry;   // 暗号化では書き、復号化では確かめ、更新では比べる
+	int known;       // 更新: 比べられる索引がある
+	int dirty;       // 更新: 書き直した、復号化: ダイジェストが合わない
+	int done;        // 暗号化 (復号化、更新) が終わった
+} chunk_t;
+
+// 読むスレッド、暗号化 (復号化) するスレッドたち、書くスレッドをつなぐリング
+// チャンク番号 n はバッファー slots[n % depth] を使い、
+//   読む: n < nwritten + depth になるまで待って読み、nread を進める
+//   暗号化: n < nread になったチャンクを ncrypt の順に取る (終わる順はばらばら)
+//   書く: slots[nwritten % depth] が終わるのを待って書き、nwritten を進める
+typedef struct {
+	mutex_t lock;
+	cond_t filled;           // 読み終わった、または終わりの合図
+	cond_t crypted;          // 暗号化が終わった、または読み込みの失敗
+	cond_t freed;            // 書き終わった、または終わりの合図
+	chunk_t *slots;
+	size_t depth;
+	uint64_t total;          // チャンクの総数
+	uint64_t nread;          // 読み終わったチャンクの数
+	uint64_t ncrypt;         // 暗号化に取ったチャンクの数
+	uint64_t nwritten;       // 書き終わったチャンクの数
+	int quit;
+	unsigned int err;        // 読むスレッドのエラー番号
+	FILE *in;
+	FILE *out;
+	uint64_t in_base;        // in のチャンク 0 の位置
+	uint64_t out_base;       // out のチャンク 0 の位置
+	work_t mode;             // 暗号化、復号化、更新、鍵の取り替え
+	CRYPTK2_KEY key;
+	CRYPTK2_KEY old_key;     // 鍵の取り替え: 元の鍵 (old の IV で)
+	const container_t *header;
+	const container_t *old;
+	index_t *entries;
+	unsigned int nthreads;
+	unsigned int running;    // io_uring: 動いているスレッドの数
+	int reading;             // 読むスレッドが起きている
+	int mapped;              // in と out をマップしたので、読み書きはしない
+	int unknown;             // ストリーム: チャンクの総数がわからないので、終わりまで読む
+	int eof;                 // 読むスレッドが終わりまで読んだ
+	size_t lookahead;        // ストリームの復号化: 終わりのぶんだけ先に読んでおく
+	uint8_t tail[CONTAINER_FOOTER_SIZE]; // 先に読んだぶん (最後はストリームの終わり)
+	size_t ntail;
+	thread_t reader;
+	thread_t threads[MAX_THREADS];
+} pipeline_t;
+
+// コマンドラインのオプション
+typedef struct {
+	size_t depth;            // リングのバッファーの数 (0 なら CPU の数から)
+	uint32_t chunk_size;     // 暗号化するときのチャンクのサイズ (v1 形式の復号化ではバッファーのサイズ)
+	int io_uring;            // 読み書きに io_uring を使う (使えなければスレッドで)
+	int map;                 // in と out をマップして、マップからマップへ暗号化する
+	int batch;               // infile のディレクトリ (リスト) のファイルをまとめて outfile のディレクトリへ
+	int watch;               // infile のディレクトリに書かれたファイルを、止めるまで outfile のディレクトリへ
+	unsigned int threads;    // スレッドの数 (0 なら CPU の数)
+} options_t;
+
+static options_t options = { 0, CHUNK_SIZE, 0, 0, 0, 0, 0 };
+
+#ifdef CRYPTOR_WATCH
+// 見張りを止める合図 (SIGINT、SIGTERM)
+static volatile sig_atomic_t watch_stop;
+#endif
+
+// ファイルを暗号化 (復号化、更新) するときの道具
+// 鍵は展開したものを全ファイル、全スレッドで共有する。バッチではスレッドごとにひとつ。
+typedef struct {
+	CRYPTK2_KEY key;
+	CRYPTK2 k2;
+	CRYPTK2_KEY old_key;     // 鍵の取り替え: 元の鍵と、それを使う状態 (ほかでは NULL)
+	CRYPTK2 k2b;
+	uint8_t *buf;            // page_alloc したバッファー (session_buffer で大きくする)
+	size_t size;
+	int batch;               // スレッドを起こさず、このスレッドだけで順に (進み具合も出さない)
+} session_t;
+
+// バッチのファイルひとつ
+typedef struct {
+	char *src;
+	char *dst;
+	uint64_t size;
+	uint64_t queued;         // 見張り: 見つけた時刻 (マイクロ秒)
+} job_t;
+
+// 見張り: ファイルひとつにかかった時間 (マイクロ秒) の分布。2 のべき乗ごとに数える
+#define LATENCY_BUCKETS 40
+
+// バッチ全体 (大きいファイルから順に、空いたスレッドが取っていく)
+// 取られたファイルはスレッドのものになる。キューが空になれば jobs ははじめから使いなおす。
+typedef struct {
+	mutex_t lock;
+	cond_t queued;           // 見張り: ファイルが増えた、または終わりの合図
+	job_t *jobs;
+	size_t njobs;
+	size_t capacity;
+	size_t next;             // 次に取るファイル
+	size_t total;            // バッチ: ファイルの総数
+	size_t done;             // 終わったファイル
+	unsigned int percent;
+	cryptmode_t mode;
+	CRYPTK2_KEY key;
+	unsigned int failed;
+	unsigned int err;        // 最初に失敗したファイルのエラー番号
+	int watching;            // 見張り: キューが空でも、終わりの合図まで待つ
+	int closing;             // 見張り: 終わりの合図 (残りを片づけたら終わる)
+	uint64_t latency[LATENCY_BUCKETS];
+	uint64_t latency_sum, latency_max;
+} batch_t;
+
+// ファイルをマップしたところ
+typedef struct {
+	uint8_t *ptr;
+	size_t size;
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+} map_t;
+
+
+#ifdef CRYPTOR_IO_URING
+// io_uring ひとつぶん (mmap した SQ と CQ)
+typedef struct {
+	int fd;
+	unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned int *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ptr, *cq_ptr;
+	size_t sq_size, cq_size, sqes_size;
+	unsigned int pending;    // まだ io_uring_enter していない SQE の数
+} ring_t;
+
+// io_uring のバッファーひとつ
+typedef struct {
+	chunk_t chunk;
+	int state;               // SLOT_FREE、SLOT_READING、SLOT_WRITING
+	size_t pos;              // 読み書きが済んだバイト数
+} io_slot_t;
+
+enum { SLOT_FREE, SLOT_READING, SLOT_WRITING };
+
+// io_uring で読み書きするスレッドひとつ
+// チャンク id, id + n, id + 2n ... を受け持ち、読み終わったものから暗号化して書く。
+typedef struct {
+	pipeline_t *p;
+	unsigned int id, n;
+	size_t depth, stride;
+	ring_t ring;
+	uint8_t *memory;
+	io_slot_t *slots;
+	thread_t thread;
+} uring_t;
+#endif
+
+
+
+// 諸関数
+static void generate_keyiv(uint8_t *buf);
+static uint64_t new_nonce(void);
+static void make_keyfile(char *filename);
+static void read_keyfile(char *filename, uint8_t *buf);
+static void open_random(void);
+static unsigned int encrypt_file(const char *src, const char *dst, session_t *s);
+static unsigned int encrypt_keys(char **args, size_t n, CRYPTK2_KEY first);
+static unsigned int decrypt_file(const char *src, const char *dst, session_t *s);
+static unsigned int update_file(const char *src, const char *dst, session_t *s);
+static unsigned int rotate_file(const char *src, const char *dst, session_t *s);
+static unsigned int batch_files(const char *src, const char *dst, cryptmode_t mode, CRYPTK2_KEY key);
+static unsigned int watch_files(const char *src, const char *dst, cryptmode_t mode, CRYPTK2_KEY key);
+static unsigned int decrypt_file_v1(FILE *in, FILE *out, uint64_t size, session_t *s);
+static unsigned int decrypt_stream_v1(FILE *in, FILE *out, const uint8_t *head, size_t nhead, session_t *s);
+static unsigned int recrypt_file_v1(FILE *in, FILE *out, uint64_t size, session_t *s);
+static unsigned int crypt_chunks(FILE *in, FILE *out, container_t *header, const container_t *old, index_t *entries, session_t *s, work_t work, const char *label);
+static index_t *new_entries(uint64_t total);
+static unsigned int read_entries(FILE *in, const container_t *header, index_t *entries);
+static unsigned int write_entries(FILE *out, const container_t *header, const index_t *entries);
+static int open_session(session_t *s, CRYPTK2_KEY key, int batch);
+static void close_session(session_t *s);
+static uint8_t *session_buffer(session_t *s, size_t size);
+static unsigned int add_job(batch_t *b, char *src, char *dst, uint64_t size);
+static unsigned int add_dir(batch_t *b, const char *src, const char *dst);
+static unsigned int add_list(batch_t *b, const char *list, const char *dst);
+static int path_info(const char *path, uint64_t *size);
+static char *join_path(const char *dir, const char *name);
+static void make_dirs(const char *path);
+static int compare_jobs(const void *a, const void *b);
+static unsigned int start_batch(batch_t *b, thread_t *threads);
+static void stop_batch(batch_t *b, thread_t *threads, unsigned int nthreads);
+static THREAD_PROC batch_main(void *arg);
+#ifdef CRYPTOR_WATCH
+static uint64_t now_us(void);
+static void watch_signal(int sig);
+static void print_latency(const batch_t *b);
+#endif
+static unsigned int count_threads(void);
+static int parse_size(const char *str, uint64_t *value);
+static void *page_alloc(size_t size);
+static int mul_size(size_t count, size_t size, size_t *bytes);
+static FILE *open_file(const char *filename, const char *mode);
+static int close_file(FILE *f);
+static FILE *open_temp(const char *path, FILE *like, char **name);
+static int get_size(FILE *f, int64_t *size);
+static int read_at(FILE *f, uint64_t offset, uint8_t *buf, size_t len);
+static int write_at(FILE *f, uint64_t offset, const uint8_t *buf, size_t len);
+static void advise_sequential(FILE *f);
+static void preallocate(FILE *f, uint64_t len);
+static void start_writeback(FILE *f, uint64_t offset, uint64_t len);
+static void drop_cache(FILE *f, uint64_t offset, uint64_t len, int written);
+static int map_file(map_t *m, FILE *f, uint64_t size, int writable);
+static void unmap_file(map_t *m);
+static int start_pipeline(pipeline_t *p, unsigned int nthreads);
+static chunk_t *next_chunk(pipeline_t *p);
+static void release_chunk(pipeline_t *p);
+static void stop_pipeline(pipeline_t *p);
+static THREAD_PROC reader_main(void *arg);
+static THREAD_PROC worker_main(void *arg);
+static int64_t read_stream(pipeline_t *p, uint8_t *buf, size_t len);
+static void prepare_chunk(pipeline_t *p, chunk_t *chunk, uint64_t index);
+static void work_chunk(pipeline_t *p, CRYPTK2 k2, CRYPTK2 k2b, chunk_t *chunk);
+#ifdef CRYPTOR_IO_URING
+static int run_uring(pipeline_t *p, unsigned int nthreads, size_t depth, size_t stride, const char *label);
+static int ring_setup(ring_t *ring, unsigned int entries);
+static void ring_free(ring_t *ring);
+static void ring_push(ring_t *ring, int opcode, int fd, uint64_t offset, uint8_t *buf, size_t len, unsigned int index);
+static int ring_enter(ring_t *ring, unsigned int wait);
+static void uring_submit(uring_t *u, io_slot_t *slot);
+static void uring_fail(pipeline_t *p, unsigned int err, const char *message, uint64_t index);
+static THREAD_PROC uring_main(void *arg);
+#endif
+
+
+#ifdef FORWARD_MAIN
+#  define main _entry
+#endif
+
+
+int main(int argc, char **argv) {
+	cryptmode_t mode;
+	uint8_t key[16];
+	uint64_t value;
+	int correct_argc, extra, i;
+	unsigned int err=0;
+	CRYPTK2_KEY keyctx, oldctx=NULL;
+	session_t session;
+
+	// 引数が 2 個より少ない場合は処理を継続できない
+	if (argc < 2) {
+arg_error:
+		fprintf(stderr,
+			"usage:\n"
+			"\tcryptk2 -m outfile\n"
+			"\tcryptk2 -d [options] keyfile infile outfile\n"
+			"\tcryptk2 -e [options] keyfile infile outfile [keyfile outfile ...]\n"
+			"\tcryptk2 -u [options] keyfile infile outfile\n"
+			"\tcryptk2 -r [options] oldkeyfile newkeyfile infile outfile\n"
+			"infile and outfile of -e and -d may be - for stdin and stdout.\n"
+			"-e with more keyfile and outfile pairs reads infile once and writes one outfile per key\n"
+			"(in one thread, without --threads, --depth, --mmap and --io-uring).\n"
+			"options:\n"
+			"\t--batch            (-e, -d) infile is a directory or a list of files, one per line;\n"
+			"\t                   each file goes to the same relative path under the directory outfile\n"
+			"\t--watch            (-e, -d) crypt each file written to the directory infile into the\n"
+			"\t                   directory outfile until interrupted, then print the latencies (Linux)\n"
+			"\t--threads n        number of threads (default: number of CPUs)\n"
+			"\t--depth n          number of buffers in flight (default: %u per CPU)\n"
+			"\t--buffer-size n    chunk size of new files, in bytes or with K/M (default: %uK, at most 256M)\n"
+			"\t--io-uring         read and write with io_uring where available (Linux)\n"
+			"\t--mmap             crypt from a mapping of infile to a mapping of outfile\n",
+			CHUNKS_PER_THREAD, CHUNK_SIZE / 1024
+		);
+		return ERROR_INVALID_ARGS;
+	}
+	
+	// モードは encrypt か decrypt か。
+	if (!strcmp(argv[1], "-m") || !strcmp(argv[1], "/m")) {
+		mode = MODE_MAKEKEY;
+		correct_argc = 3;
+	}
+	else if (!strcmp(argv[1], "-e") || !strcmp(argv[1], "/e")) {
+		mode = MODE_ENCRYPT;
+		correct_argc = 5;
+	}
+	else if (!strcmp(argv[1], "-d") || !strcmp(argv[1], "/d")) {
+		mode = MODE_DECRYPT;
+		correct_argc = 5;
+	}
+	else if (!strcmp(argv[1], "-u") || !strcmp(argv[1], "/u")) {
+		mode = MODE_UPDATE;
+		correct_argc = 5;
+	}
+	else if (!strcmp(argv[1], "-r") || !strcmp(argv[1], "/r")) {
+		mode = MODE_ROTATE;
+		correct_argc = 6;
+	}
+	else {
+		// 引数エラー
+		goto arg_error;
+	}
+
+	// オプション (鍵をつくるときは無し)
+	for (i=2; mode != MODE_MAKEKEY && i < argc && !strncmp(argv[i], "--", 2); ++i) {
+		// 値の無いオプション
+		if (!strcmp(argv[i], "--io-uring")) {
+			options.io_uring = 1;
+			continue;
+		}
+		if (!strcmp(argv[i], "--mmap")) {
+			options.map = 1;
+			continue;
+		}
+		if (!strcmp(argv[i], "--batch")) {
+			options.batch = 1;
+			continue;
+		}
+		if (!strcmp(argv[i], "--watch")) {
+			options.watch = 1;
+			continue;
+		}
+
+		// 値のあるオプション
+		if (i + 1 >= argc || !parse_size(argv[i + 1], &value) || value == 0) {
+			goto arg_error;
+		}
+		if (!strcmp(argv[i], "--depth") && value <= MAX_DEPTH) {
+			options.depth = (size_t)value;
+		}
+		else if (!strcmp(argv[i], "--buffer-size") && value <= CONTAINER_MAX_CHUNK_SIZE) {
+			options.chunk_size = (uint32_t)value;
+		}
+		else if (!strcmp(argv[i], "--threads") && value <= MAX_THREADS) {
+			options.threads = (unsigned int)value;
+		}
+		else {
+			goto arg_error;
+		}
+		++i;
+	}
+
+	// 引数の数をチェック (バッチと見張りは暗号化と復号化だけ)
+	// 暗号化では、キーファイルと出力先ファイルの組を続けられる (バッチ、見張り、ストリームは無し)
+	extra = argc - (i - 2) - correct_argc;
+	if (extra > 0 && (mode != MODE_ENCRYPT || extra % 2 != 0 || options.batch || options.watch)) {
+		goto arg_error;
+	}
+	if (extra < 0 || ((options.batch || options.watch) && mode != MODE_ENCRYPT && mode != MODE_DECRYPT) || (options.batch && options.watch)) {
+		// 引数エラー
+		goto arg_error;
+	}
+
+	// モード別の処理
+	if (mode == MODE_MAKEKEY) {
+		// 鍵の作成
+		make_keyfile(argv[i]);
+	}
+	else {
+		// キーファイルを読み込んで、展開するのは一度だけ
+		read_keyfile(argv[i], key);
+		if ((keyctx = cryptk2_key_new()) == NULL) {
+			fprintf(stderr, "error: failed to allocate memory\n");
+			return ERROR_MALLOC_FAILED;
+		}
+		cryptk2_key_expand(keyctx, key);
+		memset(key, 0, sizeof(key));
+
+		// 鍵の取り替え: はじめのキーファイルが元の鍵、次が新しい鍵
+		if (mode == MODE_ROTATE) {
+			oldctx = keyctx;
+			read_keyfile(argv[++i], key);
+			if ((keyctx = cryptk2_key_new()) == NULL) {
+				fprintf(stderr, "error: failed to allocate memory\n");
+				cryptk2_key_delete(oldctx);
+				return ERROR_MALLOC_FAILED;
+			}
+			cryptk2_key_expand(keyctx, key);
+			memset(key, 0, sizeof(key));
+		}
+
+		if (extra > 0) {
+			// いくつもの鍵で (入力は一度だけ読む)
+			err = encrypt_keys(argv + i, (size_t)extra / 2 + 1, keyctx);
+		}
+		else if (options.batch) {
+			// たくさんのファイルをまとめて
+			err = batch_files(argv[i + 1], argv[i + 2], mode, keyctx);
+		}
+		else if (options.watch) {
+			// 書かれたファイルを次々に
+			err = watch_files(argv[i + 1], argv[i + 2], mode, keyctx);
+		}
+		else if (!open_session(&session, keyctx, 0) || (oldctx != NULL && (session.k2b = new_cryptk2()) == NULL)) {
+			close_session(&session);
+			fprintf(stderr, "error: failed to allocate memory\n");
+			err = ERROR_MALLOC_FAILED;
+		}
+		else {
+			if (mode == MODE_ENCRYPT) {
+				// 暗号化
+				err = encrypt_file(argv[i + 1], argv[i + 2], &session);
+			}
+			else if (mode == MODE_UPDATE) {
+				// 変わったチャンクだけ暗号化しなおす
+				err = update_file(argv[i + 1], argv[i + 2], &session);
+			}
+			else if (mode == MODE_ROTATE) {
+				// 平文に戻さずに、新しい鍵で暗号化しなおす
+				session.old_key = oldctx;
+				err = rotate_file(argv[i + 1], argv[i + 2], &session);
+			}
+			else {
+				// 復号化
+				err = decrypt_file(argv[i + 1], argv[i + 2], &session);
+			}
+			close_session(&session);
+		}
+		cryptk2_key_delete(keyctx);
+		cryptk2_key_delete(oldctx);
+	}
+
+	// エラー番号 (正常終了なら 0)
+	return (int)err;
+}
+
+
+#ifdef _WIN32
+// CryptGenRandom のプロバイダー (一度だけ取って、プロセスが終わるまで使う)
+static HCRYPTPROV random_provider;
+#endif
+
+// 乱数の準備 (バッチではスレッドを起こす前に)
+static void open_random(void) {
+#ifdef _WIN32
+	if (random_provider == 0 && CryptAcquireContext(&random_provider, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT) == FALSE) {
+		random_provider = 0;
+	}
+#endif
+}
+
+// 16 バイトの暗号鍵 / IV をつくる
+// Windows は CryptGenRandom、Linux は getrandom、ほかの POSIX 環境は /dev/urandom から。
+static void generate_keyiv(uint8_t *buf) {
+#ifdef _WIN32
+	open_random();
+	if (random_provider == 0 || CryptGenRandom(random_provider, 16, (BYTE *)buf) == FALSE) {
+		fprintf(stderr, "error: failed to generate key\n");
+		exit(ERROR_FAILED_TO_GENERATE_IV);
+	}
+#else
+	FILE *f;
+#  ifdef __linux__
+	ssize_t n;
+	while ((n = getrandom(buf, 16, 0)) < 0 && errno == EINTR);
+	if (n == 16) {
+		return;
+	}
+#  endif
+	// getrandom の無いカーネル
+	if ((f = fopen("/dev/urandom", "rb")) == NULL || fread(buf, 1, 16, f) != 16) {
+		fprintf(stderr, "error: failed to generate key\n");
+		exit(ERROR_FAILED_TO_GENERATE_IV);
+	}
+	fclose(f);
+#endif
+}
+
+
+// 更新で書き直すチャンクのノンス (乱数。下位 8 ビットは IV の使いみちに空けておく)
+static uint64_t new_nonce(void) {
+	uint8_t buf[16];
+	uint64_t nonce = 0;
+	int i;
+
+	generate_keyiv(buf);
+	for (i=0; i<8; ++i) {
+		nonce = (nonce << 8) | buf[i];
+	}
+	return nonce & ~(uint64_t)0xff;
+}
+
+
+// キーファイルをつくる
+static void make_keyfile(char *filename) {
+	FILE *f;
+	uint8_t key[16];
+
+	// キーファイルを開く
+	if ((f = fopen(filename, "wb")) == NULL) {
+		fprintf(stderr, "error: failed to open outfile\n");
+		exit(ERROR_FAILED_TO_OPEN_OUTFILE);
+	}
+
+	// キーの作成
+	generate_keyiv(key);
+
+	// キーファイルに書き込み
+	fwrite(key, sizeof(uint8_t), 16, f);
+
+	// キーファイルを閉じる
+	fclose(f);
+}
+
+
+// キーファイルを読み込む
+static void read_keyfile(char *filename, uint8_t *buf) {
+	FILE *f;
+
+	// キーファイルを開く
+	if ((f = fopen(filename, "rb")) == NULL) {
+		fprintf(stderr, "error: failed to open keyfile\n");
+		exit(ERROR_FAILED_TO_OPEN_KEYFILE);
+	}
+
+	// キーファイルは 16 バイトでなければならない
+	fseek(f, 0, SEEK_END);
+	if (ftell(f) != 16) {
+		fprintf(stderr, "error: invalid keyfile\n");
+		fclose(f);
+		exit(ERROR_INVALID_KEYFILE);
+	}
+
+	// キーファイルの読み込み
+	fseek(f, 0, SEEK_SET);
+	fread(buf, sizeof(uint8_t), 16, f);
+
+	// キーファイルを閉じる
+	fclose(f);
+}
+
+
+// ファイルを暗号化 (v2 形式)
+// infile か outfile が "-" なら、サイズのわからないストリームとして前から順に読み書きする。エラー番号を返す。
+static unsigned int encrypt_file(const char *src, const char *dst, session_t *s) {
+	FILE *in=NULL, *out=NULL;
+	unsigned int err=0;
+	int64_t size=0;
+	int stream;
+	container_t header;
+	index_t *entries=NULL;
+
+	// 入力元ファイルを開く
+	if ((in = open_file(src, "rb")) == NULL) {
+failed_infile:
+		fprintf(stderr, "error: failed to open infile\n");
+		err = ERROR_FAILED_TO_OPEN_INFILE;
+		goto cleanup;
+	}
+
+	// 出力先ファイルを開く (マップするなら読み書き両用で)
+	if ((out = open_file(dst, options.map ? "w+b" : "wb")) == NULL) {
+		fprintf(stderr, "error: failed to open outfile\n");
+		err = ERROR_FAILED_TO_OPEN_OUTFILE;
+		goto cleanup;
+	}
+
+	// 暗号化前のファイルサイズを取得 (ストリームではわからない)
+	stream = (in == stdin || out == stdout);
+	if (!stream && !get_size(in, &size)) {
+		goto failed_infile;
+	}
+
+	// ヘッダーをつくる (基準 IV はファイルごとに新しく)
+	header.version = CONTAINER_VERSION;
+	header.flags = stream ? CONTAINER_FLAG_STREAM : (CONTAINER_FLAG_INDEX | CONTAINER_FLAG_NONCE);
+	header.chunk_size = options.chunk_size;
+	header.generation = 0;
+	header.size = (uint64_t)size;
+	generate_keyiv(header.iv);
+	write_header(out, &header);
+
+	if (stream) {
+		// チャンクごとに暗号化して、最後にサイズを書く
+		if ((err = crypt_chunks(in, out, &header, NULL, NULL, s, WORK_ENCRYPT, "encrypting")) != 0) {
+			goto cleanup;
+		}
+	}
+	else {
+		// 索引の置き場所
+		preallocate(out, index_offset(&header) + count_chunks(&header) * CONTAINER_INDEX_SIZE);
+		if ((entries = new_entries(count_chunks(&header))) == NULL) {
+			fprintf(stderr, "error: failed to allocate memory\n");
+			err = ERROR_MALLOC_FAILED;
+			goto cleanup;
+		}
+
+		// チャンクごとに暗号化して、索引を書く
+		fseek64(in, 0, SEEK_SET);
+		if ((err = crypt_chunks(in, out, &header, NULL, entries, s, WORK_ENCRYPT, "encrypting")) != 0 || (err = write_entries(out, &header, entries)) != 0) {
+			goto cleanup;
+		}
+	}
+
+	// 100 パーセント表示
+	if (!s->batch) {
+		fprintf(stderr, "\rencrypting (100 %%) completed!\n");
+	}
+
+cleanup:
+	free(entries);
+
+	// ファイルを閉じる
+	if (in != NULL) close_file(in);
+	if (out != NULL && close_file(out) && !err) {
+		fprintf(stderr, "error: failed to write outfile\n");
+		err = ERROR_FAILED_TO_WRITE_OUTFILE;
+	}
+	return err;
+}
+
+
+// ファイルをいくつもの鍵で暗号化 (v2 形式)。エラー番号を返す。
+// args は keyfile infile outfile keyfile outfile ... で、鍵 n 個 (はじめの鍵は展開したもの)。
+// 入力は一度だけ読み、チャンクごとに鍵の数だけの状態をまとめて初期化して (cryptk2_setup_keys)、
+// 同じ入力から鍵ストリームを横に並べて暗号化する (cryptk2_crypt_lanes)。ダイジェストは一度だけ計算して、
+// 鍵ごとにマスクする。出力先ファイルの IV はどれも新しく。
+// 鍵をまたいだ SIMD で並べるので、スレッドのパイプラインは使わない (--threads、--depth、--mmap、--io-uring は無し)。
+// infile か outfile のどれかひとつが "-" なら、どれもストリームとして前から順に読み書きする。
+static unsigned int encrypt_keys(char **args, size_t n, CRYPTK2_KEY first) {
+	FILE *in=NULL, **out=NULL;
+	unsigned int percent, err=0;
+	int64_t size=0;
+	int stream;
+	uint64_t index, total, offset, digest, bytes;
+	uint8_t key[16], footer[CONTAINER_FOOTER_SIZE], *memory=NULL, **bufs=NULL, *ivs=NULL;
+	const uint8_t **src=NULL, **ivp=NULL;
+	size_t j, len, stride, area=0;
+	container_t *headers=NULL;
+	index_t **entries=NULL;
+	CRYPTK2_KEY *keys=NULL;
+	CRYPTK2 *states=NULL;
+
+	// パイプラインのオプションは使えない
+	if (options.threads != 0 || options.depth != 0 || options.map || options.io_uring) {
+		fprintf(stderr, "error: --threads, --depth, --mmap and --io-uring cannot be used with multiple keys\n");
+		return ERROR_INVALID_ARGS;
+	}
+
+	// 標準出力はひとつまで
+	for (j=0, stream=0; j<n; ++j) {
+		stream += !strcmp(args[2 * j + 2], "-");
+	}
+	if (stream > 1) {
+		fprintf(stderr, "error: only one outfile may be -\n");
+		return ERROR_INVALID_ARGS;
+	}
+
+	// 鍵ごとの道具
+	out = (FILE **)calloc(n, sizeof(FILE *));
+	headers = (container_t *)calloc(n, sizeof(container_t));
+	entries = (index_t **)calloc(n, sizeof(index_t *));
+	keys = (CRYPTK2_KEY *)calloc(n, sizeof(CRYPTK2_KEY));
+	states = (CRYPTK2 *)calloc(n, sizeof(CRYPTK2));
+	bufs = (uint8_t **)calloc(n, sizeof(uint8_t *));
+	src = (const uint8_t **)calloc(n, sizeof(uint8_t *));
+	ivp = (const uint8_t **)calloc(n, sizeof(uint8_t *));
+	ivs = (uint8_t *)calloc(n, 16);
+	if (out == NULL || headers == NULL || entries == NULL || keys == NULL || states == NULL || bufs == NULL || src == NULL || ivp == NULL || ivs == NULL) {
+failed_malloc:
+		fprintf(stderr, "error: failed to allocate memory\n");
+		err = ERROR_MALLOC_FAILED;
+		goto cleanup;
+	}
+
+	// 入力元ファイルを開いて、暗号化前のファイルサイズを取得 (ストリームではわからない)
+	if ((in = open_file(args[1], "rb")) == NULL) {
+failed_infile:
+		fprintf(stderr, "error: failed to open infile\n");
+		err = ERROR_FAILED_TO_OPEN_INFILE;
+		goto cleanup;
+	}
+	stream = stream || in == stdin;
+	if (!stream && !get_size(in, &size)) {
+		goto failed_infile;
+	}
+
+	// 鍵ごとに、キーファイルを読んで展開し、出力先ファイルにヘッダーを書く
+	for (j=0; j<n; ++j) {
+		if (j == 0) {
+			keys[j] = first;
+		}
+		else {
+			read_keyfile(args[2 * j + 1], key);
+			if ((keys[j] = cryptk2_key_new()) == NULL) {
+				goto failed_malloc;
+			}
+			cryptk2_key_expand(keys[j], key);
+			memset(key, 0, sizeof(key));
+		}
+
+		if ((out[j] = open_file(args[2 * j + 2], "wb")) == NULL) {
+			fprintf(stderr, "error: failed to open outfile\n");
+			err = ERROR_FAILED_TO_OPEN_OUTFILE;
+			goto cleanup;
+		}
+		headers[j].version = CONTAINER_VERSION;
+		headers[j].flags = stream ? CONTAINER_FLAG_STREAM : (CONTAINER_FLAG_INDEX | CONTAINER_FLAG_NONCE);
+		headers[j].chunk_size = options.chunk_size;
+		headers[j].generation = 0;
+		headers[j].size = (uint64_t)size;
+		generate_keyiv(headers[j].iv);
+		write_header(out[j], &headers[j]);
+
+		if ((states[j] = new_cryptk2()) == NULL) {
+			goto failed_malloc;
+		}
+		if (!stream) {
+			preallocate(out[j], index_offset(&headers[j]) + count_chunks(&headers[j]) * CONTAINER_INDEX_SIZE);
+			if ((entries[j] = new_entries(count_chunks(&headers[j]))) == NULL) {
+				goto failed_malloc;
+			}
+		}
+		ivp[j] = ivs + 16 * j;
+	}
+
+	// 入力のバッファーと、鍵ごとの出力のバッファー (どれもページ境界から)
+	stride = ((size_t)options.chunk_size + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+	if (!mul_size(n + 1, stride, &area) || (memory = (uint8_t *)page_alloc(area)) == NULL) {
+		goto failed_malloc;
+	}
+	for (j=0; j<n; ++j) {
+		src[j] = memory;
+		bufs[j] = memory + (j + 1) * stride;
+	}
+	cryptk2_get_backend();
+	advise_sequential(in);
+
+	// 暗号化メインループ (チャンクを一度読んで、鍵の数だけ書く。ストリームは終わりまで)
+	total = stream ? 0 : count_chunks(&headers[0]);
+	for (index=0, percent=101, bytes=0; stream || index<total; ++index) {
+		offset = index * options.chunk_size;
+		if (stream) {
+			if ((len = fread(memory, 1, options.chunk_size, in)) == 0) {
+				break;
+			}
+		}
+		else {
+			len = ((uint64_t)size - offset < options.chunk_size) ? (size_t)((uint64_t)size - offset) : options.chunk_size;
+			if (!read_at(in, offset, memory, len)) {
+				fprintf(stderr, "\nerror: failed to read infile\n");
+				err = ERROR_FAILED_TO_READ_INFILE;
+				goto cleanup;
+			}
+		}
+
+		// 鍵ごとのチャンクの IV で、すべての状態をまとめて
+		for (j=0; j<n; ++j) {
+			chunk_iv(&headers[j], index, 0, ivs + 16 * j);
+		}
+		cryptk2_setup_keys(keys, n, ivp, states);
+		cryptk2_crypt_lanes(states, n, len, src, bufs);
+
+		// 索引にはダイジェストを鍵ごとにマスクして書く
+		digest = stream ? 0 : chunk_digest(memory, len);
+		for (j=0; j<n; ++j) {
+			if (!stream) {
+				entries[j][index].generation = 0;
+				entries[j][index].nonce = 0;
+				entries[j][index].digest = digest ^ chunk_mask(states[j], keys[j], &headers[j], index, 0);
+			}
+			if (!write_at(out[j], CONTAINER_HEADER_SIZE + offset, bufs[j], len)) {
+				fprintf(stderr, "\nerror: failed to write outfile\n");
+				err = ERROR_FAILED_TO_WRITE_OUTFILE;
+				goto cleanup;
+			}
+			start_writeback(out[j], CONTAINER_HEADER_SIZE + offset, len);
+		}
+		drop_cache(in, offset, len, 0);
+		bytes += len;
+
+		// パーセント表示 (変わったときだけ。ストリームは MB で)
+		if (stream) {
+			fprintf(stderr, "\rencrypting (%llu MB) ...", (unsigned long long)(bytes >> 20));
+			if (len < options.chunk_size) {
+				break;
+			}
+		}
+		else if ((unsigned int)((index + 1) * 100 / total) != percent) {
+			percent = (unsigned int)((index + 1) * 100 / total);
+			fprintf(stderr, "\rencrypting (%3u %%) ...", percent);
+		}
+	}
+	if (stream && ferror(in)) {
+		fprintf(stderr, "\nerror: failed to read infile\n");
+		err = ERROR_FAILED_TO_READ_INFILE;
+		goto cleanup;
+	}
+
+	// 索引 (ストリームは終わり) を書く
+	for (j=0; j<n; ++j) {
+		if (stream) {
+			stream_footer(states[j], keys[j], &headers[j], bytes, footer);
+			if (!write_at(out[j], CONTAINER_HEADER_SIZE + bytes, footer, CONTAINER_FOOTER_SIZE)) {
+				fprintf(stderr, "\nerror: failed to write outfile\n");
+				err = ERROR_FAILED_TO_WRITE_OUTFILE;
+				goto cleanup;
+			}
+		}
+		else if ((err = write_entries(out[j], &headers[j], entries[j])) != 0) {
+			goto cleanup;
+		}
+	}
+
+	// 100 パーセント表示
+	fprintf(stderr, "\rencrypting (100 %%) completed! (%u keys)\n", (unsigned int)n);
+
+cleanup:
+	if (memory != NULL) {
+		memset(memory, 0, area);
+		page_free(memory);
+	}
+
+	// ファイルを閉じて、鍵ごとの道具を片づける (はじめの鍵は呼び出し元で)
+	if (in != NULL) close_file(in);
+	for (j=0; j<n; ++j) {
+		if (out != NULL && out[j] != NULL && close_file(out[j]) && !err) {
+			fprintf(stderr, "error: failed to write outfile\n");
+			err = ERROR_FAILED_TO_WRITE_OUTFILE;
+		}
+		if (states != NULL) delete_cryptk2(states[j]);
+		if (keys != NULL && j > 0) cryptk2_key_delete(keys[j]);
+		if (entries != NULL) free(entries[j]);
+	}
+	free(out);
+	free(headers);
+	free(entries);
+	free(keys);
+	free(states);
+	free(bufs);
+	free(src);
+	free(ivp);
+	free(ivs);
+	return err;
+}
+
+
+// ファイルを復号化 (v2 形式でなければ v1 形式として読む)。エラー番号を返す。
+// infile が "-" なら、前から順に読む。更新したことのある索引つきの v2 形式は読めない。
+static unsigned int decrypt_file(const char *src, const char *dst, session_t *s) {
+	FILE *in=NULL, *out=NULL;
+	unsigned int err=0;
+	int64_t size;
+	uint64_t i;
+	uint8_t head[CONTAINER_HEADER_SIZE];
+	size_t got=0;
+	container_t header;
+	index_t *entries=NULL, *stored=NULL;
+	int v2;
+
+	// 入力元ファイルを開く
+	if ((in = open_file(src, "rb")) == NULL) {
+failed_infile:
+		fprintf(stderr, "error: failed to open infile\n");
+		err = ERROR_FAILED_TO_OPEN_INFILE;
+		goto cleanup;
+	}
+
+	if (in == stdin) {
+		// ストリームは先頭を読んでみて、どちらの形式か調べる
+		got = fread(head, 1, CONTAINER_HEADER_SIZE, in);
+		v2 = (got == CONTAINER_HEADER_SIZE) ? parse_header(head, CONTAINER_UNKNOWN_SIZE, &header) : 0;
+		size = 0;
+	}
+	else {
+		// 暗号化されたファイルのファイルサイズを取得
+		if (!get_size(in, &size)) {
+			goto failed_infile;
+		}
+
+		// 暗号化されたファイルのサイズは 16 バイト (初期化ベクトルのサイズ) 以上でないとおかしい
+		if (size < 16) {
+			fprintf(stderr, "error: invalid infile\n");
+			err = ERROR_INVALID_INFILE;
+			goto cleanup;
+		}
+
+		// どちらの形式か調べる
+		fseek64(in, 0, SEEK_SET);
+		v2 = read_header(in, (uint64_t)size, &header);
+	}
+	if (v2 < 0) {
+		fprintf(stderr, "error: invalid infile\n");
+		err = ERROR_INVALID_INFILE;
+		goto cleanup;
+	}
+
+	// 出力先ファイルを開く (マップするなら読み書き両用で)
+	if ((out = open_file(dst, options.map ? "w+b" : "wb")) == NULL) {
+		fprintf(stderr, "error: failed to open outfile\n");
+		err = ERROR_FAILED_TO_OPEN_OUTFILE;
+		goto cleanup;
+	}
+
+	if (v2) {
+		// 索引があれば読んでおく
+		if (header.flags & CONTAINER_FLAG_INDEX) {
+			if ((entries = new_entries(count_chunks(&header))) == NULL) {
+				fprintf(stderr, "error: failed to allocate memory\n");
+				err = ERROR_MALLOC_FAILED;
+				goto cleanup;
+			}
+			if (in != stdin) {
+				if ((err = read_entries(in, &header, entries)) != 0) {
+					goto cleanup;
+				}
+			}
+			else if (header.generation != 0) {
+				// 索引は暗号文のあとなので、チャンクごとのノンスがわからない
+				fprintf(stderr, "error: updated files cannot be decrypted from a stream\n");
+				err = ERROR_INVALID_INFILE;
+				goto cleanup;
+			}
+		}
+
+		// チャンクごとに復号化
+		preallocate(out, header.size);
+		if (in != stdin) {
+			fseek64(in, CONTAINER_HEADER_SIZE, SEEK_SET);
+		}
+		if ((err = crypt_chunks(in, out, &header, NULL, entries, s, WORK_DECRYPT, "decrypting")) != 0) {
+			goto cleanup;
+		}
+
+		// ストリームでは、あとから来た索引とダイジェストを比べる
+		if (in == stdin && (header.flags & CONTAINER_FLAG_INDEX)) {
+			if ((stored = new_entries(count_chunks(&header))) == NULL) {
+				fprintf(stderr, "error: failed to allocate memory\n");
+				err = ERROR_MALLOC_FAILED;
+				goto cleanup;
+			}
+			if ((err = read_entries(in, &header, stored)) != 0) {
+				goto cleanup;
+			}
+			for (i=0; i<count_chunks(&header); ++i) {
+				if (stored[i].generation != 0 || stored[i].nonce != 0 || stored[i].digest != entries[i].digest) {
+					fprintf(stderr, "\nerror: infile is corrupted (chunk %llu)\n", (unsigned long long)i);
+					err = ERROR_CORRUPTED_INFILE;
+					goto cleanup;
+				}
+			}
+		}
+	}
+	else if (in == stdin) {
+		// 昔ながらのひと続きの形式を、前から順に
+		if ((err = decrypt_stream_v1(in, out, head, got, s)) != 0) {
+			goto cleanup;
+		}
+	}
+	else {
+		// 昔ながらのひと続きの形式
+		preallocate(out, (uint64_t)size - 16);
+		if ((err = decrypt_file_v1(in, out, (uint64_t)size - 16, s)) != 0) {
+			goto cleanup;
+		}
+	}
+
+	// 100 パーセント表示
+	if (!s->batch) {
+		fprintf(stderr, "\rdecrypting (100 %%) completed!\n");
+	}
+
+cleanup:
+	free(entries);
+	free(stored);
+
+	// ファイルを閉じる
+	if (in != NULL) close_file(in);
+	if (out != NULL && close_file(out) && !err) {
+		fprintf(stderr, "error: failed to write outfile\n");
+		err = ERROR_FAILED_TO_WRITE_OUTFILE;
+	}
+	return err;
+}
+
+
+// outfile (索引つきの v2 形式) を infile の内容に更新する。エラー番号を返す。
+// 索引のダイジェストと比べて、変わったチャンクだけを新しいノンスの IV で暗号化しなおす。
+// 変わらないチャンクは暗号文をそのまま写して、outfile の隣の一時ファイル (名前はほかと重ならない、
+// outfile と同じモード) に新しい版を書き、ディスクに書き出してから outfile と置き換える
+// (途中で止まっても outfile は前の版のまま)。
+static unsigned int update_file(const char *src, const char *dst, session_t *s) {
+	FILE *in=NULL, *orig=NULL, *out=NULL;
+	unsigned int err=0;
+	int64_t size, origsize;
+	container_t header, old;
+	index_t *entries=NULL;
+	uint64_t i, total, rewritten, offset;
+	size_t len;
+	uint8_t *buf;
+	char *tmp=NULL;
+
+	// どちらもサイズを調べて読み直すので、標準入出力は無し
+	if (!strcmp(src, "-") || !strcmp(dst, "-")) {
+		fprintf(stderr, "error: infile and outfile of -u must be files\n");
+		return ERROR_INVALID_ARGS;
+	}
+
+	// 入力元ファイルを開く
+	if ((in = open_file(src, "rb")) == NULL) {
+failed_infile:
+		fprintf(stderr, "error: failed to open infile\n");
+		err = ERROR_FAILED_TO_OPEN_INFILE;
+		goto cleanup;
+	}
+
+	// 更新するファイルを開く (読むだけ)
+	if ((orig = open_file(dst, "rb")) == NULL) {
+		fprintf(stderr, "error: failed to open outfile\n");
+		err = ERROR_FAILED_TO_OPEN_OUTFILE;
+		goto cleanup;
+	}
+
+	// 新しい内容のファイルサイズを取得
+	if (!get_size(in, &size)) {
+		goto failed_infile;
+	}
+
+	// 更新できるのは索引つきの v2 形式だけ
+	if (!get_size(orig, &origsize) || fseek64(orig, 0, SEEK_SET)
+		|| read_header(orig, (uint64_t)origsize, &old) != 1 || !(old.flags & CONTAINER_FLAG_INDEX) || old.generation == 0xffffffffu) {
+		fprintf(stderr, "error: outfile is not updatable\n");
+		err = ERROR_NOT_UPDATABLE;
+		goto cleanup;
+	}
+
+	// 新しいヘッダー: 世代をひとつ進める
+	header = old;
+	header.size = (uint64_t)size;
+	++header.generation;
+
+	// いまの索引を読む (増えたぶんは 0 のまま)
+	total = count_chunks(&header);
+	if (count_chunks(&old) > total) {
+		total = count_chunks(&old);
+	}
+	if ((entries = new_entries(total)) == NULL) {
+failed_malloc:
+		fprintf(stderr, "error: failed to allocate memory\n");
+		err = ERROR_MALLOC_FAILED;
+		goto cleanup;
+	}
+	if ((err = read_entries(orig, &old, entries)) != 0) {
+		goto cleanup;
+	}
+
+	// 新しい版は outfile の隣の一時ファイルに
+	if ((out = open_temp(dst, orig, &tmp)) == NULL) {
+		fprintf(stderr, "error: failed to create a temporary file for outfile\n");
+		err = ERROR_FAILED_TO_OPEN_OUTFILE;
+		goto cleanup;
+	}
+	write_header(out, &header);
+	preallocate(out, index_offset(&header) + count_chunks(&header) * CONTAINER_INDEX_SIZE);
+
+	// 変わったチャンクだけ暗号化しなおす (ノンスの乱数はスレッドを起こす前に準備しておく)
+	open_random();
+	fseek64(in, 0, SEEK_SET);
+	if ((err = crypt_chunks(in, out, &header, &old, entries, s, WORK_UPDATE, "updating")) != 0) {
+		goto cleanup;
+	}
+
+	// 変わらなかったチャンクは、元のファイルの暗号文をそのまま写す
+	if ((buf = session_buffer(s, header.chunk_size)) == NULL) {
+		goto failed_malloc;
+	}
+	rewritten = 0;
+	for (i=0; i<count_chunks(&header); ++i) {
+		if (entries[i].generation == header.generation) {
+			++rewritten;
+			continue;
+		}
+		offset = CONTAINER_HEADER_SIZE + i * header.chunk_size;
+		len = (header.size - i * header.chunk_size < header.chunk_size) ? (size_t)(header.size - i * header.chunk_size) : header.chunk_size;
+		if (!read_at(orig, offset, buf, len)) {
+			fprintf(stderr, "\nerror: failed to read outfile\n");
+			err = ERROR_FAILED_TO_READ_INFILE;
+			goto cleanup;
+		}
+		if (!write_at(out, offset, buf, len)) {
+failed_write:
+			fprintf(stderr, "\nerror: failed to write outfile\n");
+			err = ERROR_FAILED_TO_WRITE_OUTFILE;
+			goto cleanup;
+		}
+	}
+
+	// 索引を書いて、ディスクに書き出してから置き換える
+	if ((err = write_entries(out, &header, entries)) != 0) {
+		goto cleanup;
+	}
+	if (fflush(out) || sync_file(out)) {
+		goto failed_write;
+	}
+	close_file(orig);
+	orig = NULL;
+	if (close_file(out)) {
+		out = NULL;
+		goto failed_write;
+	}
+	out = NULL;
+	if (replace_file(tmp, dst)) {
+		fprintf(stderr, "\nerror: failed to replace outfile\n");
+		err = ERROR_FAILED_TO_WRITE_OUTFILE;
+		goto cleanup;
+	}
+
+	// 書き直したチャンクの数
+	fprintf(stderr, "\rupdating (100 %%) completed! (%llu of %llu chunks rewritten)\n", (unsigned long long)rewritten, (unsigned long long)count_chunks(&header));
+
+cleanup:
+	free(entries);
+
+	// ファイルを閉じる (失敗したら一時ファイルは消す。outfile は前の版のまま)
+	if (in != NULL) close_file(in);
+	if (orig != NULL) close_file(orig);
+	if (out != NULL) close_file(out);
+	if (err && tmp != NULL) {
+		remove(tmp);
+	}
+	free(tmp);
+	return err;
+}
+
+
+// 元の鍵で暗号化した infile を、新しい鍵で暗号化しなおして outfile に書く。エラー番号を返す。
+// 平文には戻さず、チャンクごとに元の鍵ストリームと新しい鍵ストリームを一度に XOR する。
+// v2 形式はチャンクのサイズとフラグをそのままに、基準 IV を新しくして世代 0 から。v1 形式は v1 形式のまま。
+static unsigned int rotate_file(const char *src, const char *dst, session_t *s) {
+	FILE *in=NULL, *out=NULL;
+	unsigned int err=0;
+	int64_t size;
+	container_t header, old, written;
+	index_t *entries=NULL;
+	int v2;
+
+	// 入力元ファイルを開く (元の索引やストリームの終わりを読むので、標準入力は無し)
+	if (!strcmp(src, "-")) {
+		fprintf(stderr, "error: infile of -r must be a file\n");
+		err = ERROR_INVALID_ARGS;
+		goto cleanup;
+	}
+	if ((in = open_file(src, "rb")) == NULL) {
+failed_infile:
+		fprintf(stderr, "error: failed to open infile\n");
+		err = ERROR_FAILED_TO_OPEN_INFILE;
+		goto cleanup;
+	}
+
+	// 暗号化されたファイルのファイルサイズを取得 (16 バイト以上でないとおかしい)
+	if (!get_size(in, &size)) {
+		goto failed_infile;
+	}
+	fseek64(in, 0, SEEK_SET);
+	if (size < 16 || (v2 = read_header(in, (uint64_t)size, &old)) < 0) {
+		fprintf(stderr, "error: invalid infile\n");
+		err = ERROR_INVALID_INFILE;
+		goto cleanup;
+	}
+
+	// 出力先ファイルを開く (マップするなら読み書き両用で。標準出力には前から順に書く)
+	if ((out = open_file(dst, options.map ? "w+b" : "wb")) == NULL) {
+		fprintf(stderr, "error: failed to open outfile\n");
+		err = ERROR_FAILED_TO_OPEN_OUTFILE;
+		goto cleanup;
+	}
+	preallocate(out, (uint64_t)size);
+
+	if (v2) {
+		// 新しいヘッダー: 基準 IV を新しくして、どのチャンクも世代 0 (ノンス 0) に
+		header = old;
+		header.generation = 0;
+		generate_keyiv(header.iv);
+
+		// 索引があれば、チャンクごとのノンスとダイジェストを読んでおく
+		if (header.flags & CONTAINER_FLAG_INDEX) {
+			if ((entries = new_entries(count_chunks(&header))) == NULL) {
+				fprintf(stderr, "error: failed to allocate memory\n");
+				err = ERROR_MALLOC_FAILED;
+				goto cleanup;
+			}
+			if ((err = read_entries(in, &old, entries)) != 0) {
+				goto cleanup;
+			}
+		}
+
+		// ストリームのヘッダーはサイズ 0 のまま
+		written = header;
+		if (header.flags & CONTAINER_FLAG_STREAM) {
+			written.size = 0;
+		}
+		write_header(out, &written);
+
+		// チャンクごとに鍵を取り替えて、索引を書く (ストリームは終わりを書きなおす)
+		fseek64(in, CONTAINER_HEADER_SIZE, SEEK_SET);
+		if ((err = crypt_chunks(in, out, &header, &old, entries, s, WORK_RECRYPT, "rotating")) != 0) {
+			goto cleanup;
+		}
+		if (entries != NULL && (err = write_entries(out, &header, entries)) != 0) {
+			goto cleanup;
+		}
+	}
+	else {
+		// 昔ながらのひと続きの形式
+		if ((err = recrypt_file_v1(in, out, (uint64_t)size - 16, s)) != 0) {
+			goto cleanup;
+		}
+	}
+
+	// 100 パーセント表示
+	fprintf(stderr, "\rrotating (100 %%) completed!\n");
+
+cleanup:
+	free(entries);
+
+	// ファイルを閉じる
+	if (in != NULL) close_file(in);
+	if (out != NULL && close_file(out) && !err) {
+		fprintf(stderr, "error: failed to write outfile\n");
+		err = ERROR_FAILED_TO_WRITE_OUTFILE;
+	}
+	return err;
+}
+
+
+// たくさんのファイルをまとめて暗号化 (復号化) する。最初に失敗したファイルのエラー番号を返す。
+// src がディレクトリならその下のファイルすべて、そうでなければ 1 行にひとつファイル名を書いたリスト。
+// dst のディレクトリの下の同じ相対パスに書く。鍵の展開は一度だけで、ファイルは大きいものから順に
+// 空いたスレッドが取っていく (ひとつのファイルはひとつのスレッドで、スレッドごとの状態とバッファーで)。
+static unsigned int batch_files(const char *src, const char *dst, cryptmode_t mode, CRYPTK2_KEY key) {
+	batch_t batch;
+	thread_t threads[MAX_THREADS];
+	unsigned int nthreads, err;
+	uint64_t size;
+	size_t j;
+
+	memset(&batch, 0, sizeof(batch));
+	batch.percent = 101;
+	batch.mode = mode;
+	batch.key = key;
+
+	// ファイルを集めて、大きいものから
+	switch (path_info(src, &size)) {
+	case 2:
+		err = add_dir(&batch, src, dst);
+		break;
+	case 1:
+		err = add_list(&batch, src, dst);
+		break;
+	default:
+		fprintf(stderr, "error: failed to open infile\n");
+		err = ERROR_FAILED_TO_OPEN_INFILE;
+		break;
+	}
+	if (err) {
+		goto cleanup;
+	}
+	qsort(batch.jobs, batch.njobs, sizeof(job_t), compare_jobs);
+
+	// スレッドを起こして (ひとつも起きなければこのスレッドで)、全部終わるのを待つ
+	batch.total = batch.njobs;
+	if ((nthreads = start_batch(&batch, threads)) == 0) {
+		batch_main(&batch);
+	}
+	stop_batch(&batch, threads, nthreads);
+
+	// どのスレッドも道具をととのえられなかった
+	if (batch.next < batch.njobs) {
+		fprintf(stderr, "\nerror: failed to allocate memory\n");
+		err = ERROR_MALLOC_FAILED;
+		goto cleanup;
+	}
+
+	fprintf(stderr, "\r%s (%llu files) completed!", (mode == MODE_ENCRYPT) ? "encrypting" : "decrypting", (unsigned long long)batch.done);
+	if (batch.failed) {
+		fprintf(stderr, " (%u failed)", batch.failed);
+	}
+	fprintf(stderr, "\n");
+	err = batch.err;
+
+cleanup:
+	for (j=batch.next; j<batch.njobs; ++j) {
+		free(batch.jobs[j].src);
+		free(batch.jobs[j].dst);
+	}
+	free(batch.jobs);
+	return err;
+}
+
+
+// ディレクトリ src を見張って、書き終わったファイル (移ってきたファイル) を dst の同じ名前に
+// 暗号化 (復号化) する。SIGINT か SIGTERM で、残りを片づけてから、かかった時間の分布を出して終わる。
+// スレッドと道具 (鍵、状態、バッファー) は起きたまま待つので、ファイルごとの手間はキューに入れるだけ。
+// サブディレクトリは見ない。
+static unsigned int watch_files(const char *src, const char *dst, cryptmode_t mode, CRYPTK2_KEY key) {
+#ifdef CRYPTOR_WATCH
+	batch_t batch;
+	thread_t threads[MAX_THREADS];
+	unsigned int nthreads, err=0;
+	union {
+		struct inotify_event event;
+		char buf[4096];
+	} events;
+	const struct inotify_event *e;
+	struct sigaction sa;
+	sigset_t mask, old;
+	ssize_t n, i;
+	uint64_t now;
+	int fd;
+
+	memset(&batch, 0, sizeof(batch));
+	batch.mode = mode;
+	batch.key = key;
+	batch.watching = 1;
+
+	// 書き終わったファイルと、移ってきたファイル
+	if ((fd = inotify_init1(IN_CLOEXEC)) < 0 || inotify_add_watch(fd, src, IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0) {
+		fprintf(stderr, "error: failed to watch %s\n", src);
+		if (fd >= 0) close(fd);
+		return ERROR_FAILED_TO_OPEN_INFILE;
+	}
+
+	// 止める合図はこのスレッドで受ける (read が EINTR で戻るように、SA_RESTART はつけない)
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = watch_signal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &mask, &old);
+	nthreads = start_batch(&batch, threads);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (nthreads == 0) {
+		fprintf(stderr, "error: failed to create thread\n");
+		close(fd);
+		return ERROR_FAILED_TO_CREATE_THREAD;
+	}
+	fprintf(stderr, "watching %s with %u threads (interrupt to stop) ...\n", src, nthreads);
+
+	while (!watch_stop && !err) {
+		if ((n = read(fd, events.buf, sizeof(events.buf))) < 0) {
+			if (errno == EINTR) continue;
+			fprintf(stderr, "error: failed to watch %s\n", src);
+			err = ERROR_FAILED_TO_READ_INFILE;
+			break;
+		}
+		now = now_us();
+
+		// 見つけたファイルをキューに入れる
+		mutex_lock(&batch.lock);
+		for (i=0; i<n; i+=(ssize_t)(sizeof(struct inotify_event) + e->len)) {
+			e = (const struct inotify_event *)(events.buf + i);
+			if (e->mask & IN_Q_OVERFLOW) {
+				fprintf(stderr, "warning: too many events, some files were missed\n");
+			}
+			if (e->len == 0 || (e->mask & IN_ISDIR)) {
+				continue;
+			}
+			if ((err = add_job(&batch, join_path(src, e->name), join_path(dst, e->name), 0)) != 0) {
+				break;
+			}
+			batch.jobs[batch.njobs - 1].queued = now;
+		}
+		cond_broadcast(&batch.queued);
+		mutex_unlock(&batch.lock);
+	}
+
+	// キューを片づけてから終わる
+	stop_batch(&batch, threads, nthreads);
+	close(fd);
+
+	fprintf(stderr, "\n%llu files", (unsigned long long)batch.done);
+	if (batch.failed) {
+		fprintf(stderr, " (%u failed)", batch.failed);
+	}
+	fprintf(stderr, "\n");
+	print_latency(&batch);
+	free(batch.jobs);
+	return err ? err : batch.err;
+#else
+	(void)src;
+	(void)dst;
+	(void)mode;
+	(void)key;
+	fprintf(stderr, "error: --watch is not supported on this platform\n");
+	return ERROR_INVALID_ARGS;
+#endif
+}
+
+
+// v1 形式 (16 バイトの IV とひと続きの暗号文) を復号化。エラー番号を返す。
+static unsigned int decrypt_file_v1(FILE *in, FILE *out, uint64_t size, session_t *s) {
+	uint64_t offset;
+	size_t n;
+	unsigned int percent, err=0;
+	uint8_t iv[16];
+	uint8_t *buf;
+
+	// バッファーはオプションの大きさで
+	if ((buf = session_buffer(s, options.chunk_size)) == NULL) {
+		fprintf(stderr, "error: failed to allocate memory\n");
+		return ERROR_MALLOC_FAILED;
+	}
+
+	// 初期化ベクトルを読み込む
+	if (!read_at(in, 0, iv, 16)) {
+		fprintf(stderr, "error: failed to read infile\n");
+		return ERROR_FAILED_TO_READ_INFILE;
+	}
+
+	// 暗号ライブラリー初期化
+	cryptk2_setup_iv(s->k2, s->key, iv);
+	advise_sequential(in);
+
+	// 復号化メインループ
+	for (offset=0, percent=101; offset<size; offset+=n) {
+		n = (size - offset < options.chunk_size) ? (size_t)(size - offset) : options.chunk_size;
+
+		// ファイル in から復号化前のデータを読み込み
+		if (!read_at(in, 16 + offset, buf, n)) {
+			fprintf(stderr, "\nerror: failed to read infile\n");
+			err = ERROR_FAILED_TO_READ_INFILE;
+			break;
+		}
+		// 復号化
+		cryptk2_decrypt(s->k2, n, buf, buf);
+		// ファイル out へ復号化後のデータを書き込み
+		if (!write_at(out, offset, buf, n)) {
+			fprintf(stderr, "\nerror: failed to write outfile\n");
+			err = ERROR_FAILED_TO_WRITE_OUTFILE;
+			break;
+		}
+		drop_cache(in, 16 + offset, n, 0);
+
+		// パーセント表示 (変わったときだけ)
+		if (!s->batch && (unsigned int)((offset + n) * 100 / size) != percent) {
+			percent = (unsigned int)((offset + n) * 100 / size);
+			fprintf(stderr, "\rdecrypting (%3u %%) ...", percent);
+		}
+	}
+	return err;
+}
+
+
+// v1 形式をストリームから復号化。先に読んだ head も使う。エラー番号を返す。
+static unsigned int decrypt_stream_v1(FILE *in, FILE *out, const uint8_t *head, size_t nhead, session_t *s) {
+	uint64_t total=0;
+	size_t n, size;
+	unsigned int err=0;
+	uint8_t *buf;
+
+	// IV もなければおかしい
+	if (nhead < 16) {
+		fprintf(stderr, "error: invalid infile\n");
+		return ERROR_INVALID_INFILE;
+	}
+
+	// バッファーはオプションの大きさ (先に読んだぶんは入るように)
+	size = (options.chunk_size < CONTAINER_HEADER_SIZE) ? CONTAINER_HEADER_SIZE : options.chunk_size;
+	if ((buf = session_buffer(s, size)) == NULL) {
+		fprintf(stderr, "error: failed to allocate memory\n");
+		return ERROR_MALLOC_FAILED;
+	}
+
+	// 暗号ライブラリー初期化
+	cryptk2_setup_iv(s->k2, s->key, head);
+
+	// 先に読んだ IV のあとから、終わりまで
+	n = nhead - 16;
+	memcpy(buf, head + 16, n);
+	for (;;) {
+		n += fread(buf + n, 1, size - n, in);
+		if (n == 0) {
+			break;
+		}
+		cryptk2_decrypt(s->k2, n, buf, buf);
+		if (fwrite(buf, 1, n, out) != n) {
+			fprintf(stderr, "\nerror: failed to write outfile\n");
+			err = ERROR_FAILED_TO_WRITE_OUTFILE;
+			break;
+		}
+		total += n;
+		n = 0;
+		fprintf(stderr, "\rdecrypting (%llu MB) ...", (unsigned long long)(total >> 20));
+	}
+	if (!err && ferror(in)) {
+		fprintf(stderr, "\nerror: failed to read infile\n");
+		err = ERROR_FAILED_TO_READ_INFILE;
+	}
+	return err;
+}
+
+
+// v1 形式を新しい鍵で暗号化しなおす (v1 形式のまま、IV は新しく)。エラー番号を返す。
+static unsigned int recrypt_file_v1(FILE *in, FILE *out, uint64_t size, session_t *s) {
+	uint64_t offset;
+	size_t n;
+	unsigned int percent, err=0;
+	uint8_t iv[16];
+	uint8_t *buf;
+
+	// バッファーはオプションの大きさで
+	if ((buf = session_buffer(s, options.chunk_size)) == NULL) {
+		fprintf(stderr, "error: failed to allocate memory\n");
+		return ERROR_MALLOC_FAILED;
+	}
+
+	// 元の初期化ベクトルを読み込んで、新しい初期化ベクトルを書く
+	if (!read_at(in, 0, iv, 16)) {
+		fprintf(stderr, "error: failed to read infile\n");
+		return ERROR_FAILED_TO_READ_INFILE;
+	}
+	cryptk2_setup_iv(s->k2b, s->old_key, iv);
+	generate_keyiv(iv);
+	if (!write_at(out, 0, iv, 16)) {
+		fprintf(stderr, "error: failed to write outfile\n");
+		return ERROR_FAILED_TO_WRITE_OUTFILE;
+	}
+	cryptk2_setup_iv(s->k2, s->key, iv);
+	advise_sequential(in);
+
+	// 鍵の取り替えメインループ (どちらの鍵ストリームも続けて進む)
+	for (offset=0, percent=101; offset<size; offset+=n) {
+		n = (size - offset < options.chunk_size) ? (size_t)(size - offset) : options.chunk_size;
+
+		if (!read_at(in, 16 + offset, buf, n)) {
+			fprintf(stderr, "\nerror: failed to read infile\n");
+			err = ERROR_FAILED_TO_READ_INFILE;
+			break;
+		}
+		cryptk2_recrypt(s->k2b, s->k2, n, buf, buf);
+		if (!write_at(out, 16 + offset, buf, n)) {
+			fprintf(stderr, "\nerror: failed to write outfile\n");
+			err = ERROR_FAILED_TO_WRITE_OUTFILE;
+			break;
+		}
+		drop_cache(in, 16 + offset, n, 0);
+
+		// パーセント表示 (変わったときだけ)
+		if ((unsigned int)((offset + n) * 100 / size) != percent) {
+			percent = (unsigned int)((offset + n) * 100 / size);
+			fprintf(stderr, "\rrotating (%3u %%) ...", percent);
+		}
+	}
+	return err;
+}
+
+
+// in のチャンクを暗号化 (復号化、更新) して out に書く。エラー番号を返す。
+// 読むスレッド、暗号化するスレッドたち、書くスレッド (呼び出したスレッド) が
+// ページ境界にそろえたバッファーのリングを回すので、読み書きと暗号化が重なる。
+//   WORK_ENCRYPT  entries に索引を書く
+//   WORK_DECRYPT  entries (索引がなければ 0) のノンスで復号化して、ダイジェストを確かめる
+//   WORK_UPDATE   old の entries と比べて、変わったチャンクだけ out の元の位置に書く
+//   WORK_RECRYPT  old と entries のノンスの元の鍵で外して、header の新しい鍵で暗号化する (索引はマスクしなおす)
+// ストリーム (CONTAINER_FLAG_STREAM) ならチャンクのあとに終わりを書く (確かめる)。
+// サイズのわからないストリームは in の終わりまで読んで、header->size にサイズを入れる。
+static unsigned int crypt_chunks(FILE *in, FILE *out, container_t *header, const container_t *old, index_t *entries, session_t *s, work_t work, const char *label) {
+	pipeline_t pipeline;
+	chunk_t *chunk, single;
+	map_t inmap, outmap;
+	uint8_t *memory;
+	uint64_t index, offset, bytes;
+	int64_t in_base, out_base;
+	size_t i, depth, stride, total;
+	unsigned int nthreads, percent, err=0;
+	uint8_t footer[CONTAINER_FOOTER_SIZE], check[CONTAINER_FOOTER_SIZE];
+
+	// チャンクの総数 (サイズのわからないストリームは終わりまで)
+	pipeline.unknown = (header->flags & CONTAINER_FLAG_STREAM) && header->size == 0 && (in == stdin || work == WORK_ENCRYPT);
+	pipeline.total = pipeline.unknown ? CONTAINER_UNKNOWN_SIZE : count_chunks(header);
+
+	// どちらのファイルもいまの位置から、チャンクの番号で決まる位置に読み書きする (標準入出力は前から順に)
+	in_base = (in == stdin) ? 0 : ftell64(in);
+	out_base = (out == stdout) ? 0 : ftell64(out);
+	if (in_base < 0 || out_base < 0 || fflush(out)) {
+		fprintf(stderr, "error: failed to write outfile\n");
+		return ERROR_FAILED_TO_WRITE_OUTFILE;
+	}
+	advise_sequential(in);
+
+	// スレッドの数とリングの深さ
+	nthreads = count_threads();
+	depth = (options.depth != 0) ? options.depth : (size_t)nthreads * CHUNKS_PER_THREAD;
+	if (depth > pipeline.total) {
+		depth = (size_t)pipeline.total;
+	}
+
+	// バッファーはどれもページ境界から、チャンクの大きさ (ファイルのほうが小さければファイルの大きさ)。
+	// ストリームの復号化は、先に読む終わりのぶんも
+	pipeline.lookahead = (pipeline.unknown && work == WORK_DECRYPT) ? CONTAINER_FOOTER_SIZE : 0;
+	pipeline.ntail = 0;
+	stride = (!pipeline.unknown && header->size < header->chunk_size) ? (size_t)header->size : (size_t)header->chunk_size;
+	stride = (stride + pipeline.lookahead + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+
+	// 鍵は全チャンク共通
+	memory = NULL;
+	pipeline.slots = NULL;
+	inmap.ptr = outmap.ptr = NULL;
+
+	// CPU に合わせた処理の選択は、スレッドを起こす前に済ませておく
+	cryptk2_get_backend();
+
+	// 空のファイル
+	bytes = 0;
+	if (pipeline.total == 0) {
+		goto footer;
+	}
+
+	pipeline.depth = depth;
+	pipeline.in = in;
+	pipeline.out = out;
+	pipeline.in_base = (uint64_t)in_base;
+	pipeline.out_base = (uint64_t)out_base;
+	pipeline.mode = work;
+	pipeline.key = s->key;
+	pipeline.old_key = s->old_key;
+	pipeline.header = header;
+	pipeline.old = old;
+	pipeline.entries = entries;
+	pipeline.mapped = 0;
+
+	// バッチ: スレッドは起こさず、このスレッドのバッファーで順に
+	if (s->batch) {
+		if ((single.buf = session_buffer(s, stride)) == NULL) {
+			fprintf(stderr, "error: failed to allocate memory\n");
+			err = ERROR_MALLOC_FAILED;
+			goto cleanup;
+		}
+		single.src = single.buf;
+		for (index=0; index<pipeline.total; ++index) {
+			prepare_chunk(&pipeline, &single, index);
+			offset = index * header->chunk_size;
+			if (!read_at(in, (uint64_t)in_base + offset, single.buf, single.len)) {
+				fprintf(stderr, "error: failed to read infile\n");
+				err = ERROR_FAILED_TO_READ_INFILE;
+				goto cleanup;
+			}
+			work_chunk(&pipeline, s->k2, s->k2b, &single);
+			if (entries != NULL) {
+				entries[index] = single.entry;
+			}
+			if (work == WORK_DECRYPT && single.dirty) {
+				fprintf(stderr, "error: infile is corrupted (chunk %llu)\n", (unsigned long long)index);
+				err = ERROR_CORRUPTED_INFILE;
+				goto cleanup;
+			}
+			if ((work != WORK_UPDATE || single.dirty) && !write_at(out, (uint64_t)out_base + offset, single.buf, single.len)) {
+				fprintf(stderr, "error: failed to write outfile\n");
+				err = ERROR_FAILED_TO_WRITE_OUTFILE;
+				goto cleanup;
+			}
+		}
+		goto footer;
+	}
+
+	// ストリームは前から順に読み書きするだけ
+	if ((options.map || options.io_uring) && (in == stdin || out == stdout || pipeline.unknown)) {
+		fprintf(stderr, "warning: streams are read and written in order, using threads\n");
+		goto threads;
+	}
+
+	// マップできれば、チャンクはどれもマップの中を指すだけ
+	if (options.map) {
+		if (map_file(&inmap, in, (uint64_t)in_base + header->size, 0) && map_file(&outmap, out, (uint64_t)out_base + header->size, 1)) {
+			if ((pipeline.slots = (chunk_t *)calloc((size_t)pipeline.total, sizeof(chunk_t))) == NULL) {
+				fprintf(stderr, "error: failed to allocate memory\n");
+				err = ERROR_MALLOC_FAILED;
+				goto cleanup;
+			}
+			pipeline.depth = depth = (size_t)pipeline.total;
+			pipeline.mapped = 1;
+			for (index=0; index<pipeline.total; ++index) {
+				pipeline.slots[index].src = inmap.ptr + in_base + index * header->chunk_size;
+				pipeline.slots[index].buf = outmap.ptr + out_base + index * header->chunk_size;
+			}
+			goto start;
+		}
+		unmap_file(&inmap);
+		unmap_file(&outmap);
+		fprintf(stderr, "warning: failed to map files, reading and writing instead\n");
+	}
+
+#ifdef CRYPTOR_IO_URING
+	// io_uring が使えなければ、いつものスレッドたちで
+	if (options.io_uring) {
+		int result = run_uring(&pipeline, nthreads, depth, stride, label);
+		if (result >= 0) {
+			err = (unsigned int)result;
+			goto footer;
+		}
+	}
+#endif
+	if (options.io_uring) {
+		fprintf(stderr, "warning: io_uring is unavailable, using threads\n");
+	}
+
+threads:
+	pipeline.slots = (chunk_t *)calloc(depth, sizeof(chunk_t));
+	memory = mul_size(depth, stride, &total) ? (uint8_t *)page_alloc(total) : NULL;
+	if (pipeline.slots == NULL || memory == NULL) {
+		fprintf(stderr, "error: failed to allocate memory\n");
+		err = ERROR_MALLOC_FAILED;
+		goto cleanup;
+	}
+	for (i=0; i<depth; ++i) {
+		pipeline.slots[i].src = pipeline.slots[i].buf = memory + i * stride;
+	}
+
+start:
+	if (!start_pipeline(&pipeline, nthreads)) {
+		fprintf(stderr, "error: failed to create thread\n");
+		err = ERROR_FAILED_TO_CREATE_THREAD;
+		goto cleanup;
+	}
+
+	// 書くのはこのスレッドで、チャンクの順に (読むスレッドが終わりまで読んで、書き終わるまで)
+	for (index=0, percent=101; ; ++index) {
+		if ((chunk = next_chunk(&pipeline)) == NULL) {
+			err = pipeline.err;
+			break;
+		}
+		if (entries != NULL) {
+			entries[index] = chunk->entry;
+		}
+		bytes += chunk->len;
+
+		// 復号化: 索引のダイジェストと合わない (標準入力では索引があとから来るので、あとで比べる)
+		if (work == WORK_DECRYPT && chunk->dirty && in != stdin) {
+			fprintf(stderr, "\nerror: infile is corrupted (chunk %llu)\n", (unsigned long long)chunk->index);
+			err = ERROR_CORRUPTED_INFILE;
+			break;
+		}
+
+		// マップしていれば、暗号化したときに書き終わっている
+		if (pipeline.mapped) {
+			release_chunk(&pipeline);
+			goto progress;
+		}
+
+		// ファイル out へ書き込み (更新: 書き直したチャンクだけ元の位置へ)
+		offset = (uint64_t)out_base + index * header->chunk_size;
+		if ((work != WORK_UPDATE || chunk->dirty) && !write_at(out, offset, chunk->buf, chunk->len)) {
+			fprintf(stderr, "\nerror: failed to write outfile\n");
+			err = ERROR_FAILED_TO_WRITE_OUTFILE;
+			break;
+		}
+
+		// 読み終わった in と、書いてしばらく経った out はページキャッシュから外す
+		drop_cache(in, (uint64_t)in_base + index * header->chunk_size, chunk->len, 0);
+		if (work != WORK_UPDATE) {
+			start_writeback(out, offset, chunk->len);
+			if (index >= depth) {
+				drop_cache(out, offset - (uint64_t)depth * header->chunk_size, header->chunk_size, 1);
+			}
+		}
+		release_chunk(&pipeline);
+
+progress:
+		// パーセント表示 (変わったときだけ。総数がわからなければ MB で)
+		if (pipeline.unknown) {
+			fprintf(stderr, "\r%s (%llu MB) ...", label, (unsigned long long)(bytes >> 20));
+		}
+		else if ((unsigned int)((index + 1) * 100 / pipeline.total) != percent) {
+			percent = (unsigned int)((index + 1) * 100 / pipeline.total);
+			fprintf(stderr, "\r%s (%3u %%) ...", label, percent);
+		}
+	}
+
+	stop_pipeline(&pipeline);
+	if (pipeline.unknown) {
+		header->size = bytes;
+	}
+
+footer:
+	// ストリームの終わり: 暗号化ではサイズを書き、復号化では読んだぶんと合うか確かめる
+	// (鍵の取り替えでは、元の鍵で確かめてから新しい鍵で書く)
+	if (!err && (header->flags & CONTAINER_FLAG_STREAM)) {
+		if (work != WORK_ENCRYPT) {
+			if (work == WORK_RECRYPT) {
+				stream_footer(s->k2, s->old_key, old, header->size, footer);
+			}
+			else {
+				stream_footer(s->k2, s->key, header, header->size, footer);
+			}
+			if (pipeline.unknown) {
+				i = pipeline.ntail;
+				memcpy(check, pipeline.tail, i);
+			}
+			else {
+				i = read_at(in, (uint64_t)in_base + header->size, check, CONTAINER_FOOTER_SIZE) ? CONTAINER_FOOTER_SIZE : 0;
+			}
+			if (i != CONTAINER_FOOTER_SIZE || memcmp(check, footer, CONTAINER_FOOTER_SIZE)) {
+				fprintf(stderr, "\nerror: infile is truncated or corrupted\n");
+				err = ERROR_CORRUPTED_INFILE;
+			}
+		}
+
+		if (!err && work != WORK_DECRYPT) {
+			stream_footer(s->k2, s->key, header, header->size, footer);
+			if (!write_at(out, (uint64_t)out_base + header->size, footer, CONTAINER_FOOTER_SIZE)) {
+				fprintf(stderr, "\nerror: failed to write outfile\n");
+				err = ERROR_FAILED_TO_WRITE_OUTFILE;
+			}
+		}
+	}
+
+cleanup:
+	unmap_file(&inmap);
+	unmap_file(&outmap);
+
+	// 暗号ライブラリーお掃除
+	if (memory != NULL) {
+		memset(memory, 0, depth * stride);
+		page_free(memory);
+	}
+	free(pipeline.slots);
+	return err;
+}
+
+
+// チャンク total 個ぶんの索引 (とひとつ余分に) を 0 で。多すぎるか、できなければ NULL
+static index_t *new_entries(uint64_t total) {
+	if (total >= SIZE_MAX / sizeof(index_t)) {
+		return NULL;
+	}
+	return (index_t *)calloc((size_t)total + 1, sizeof(index_t));
+}
+
+// 索引をまとめて読む (ファイルの位置は変わる。標準入力はいまの位置から)
+static unsigned int read_entries(FILE *in, const container_t *header, index_t *entries) {
+	uint8_t buf[CONTAINER_INDEX_SIZE];
+	uint64_t i, total = count_chunks(header);
+
+	if (in != stdin) {
+		fseek64(in, (int64_t)index_offset(header), SEEK_SET);
+	}
+	for (i=0; i<total; ++i) {
+		if (fread(buf, 1, CONTAINER_INDEX_SIZE, in) != CONTAINER_INDEX_SIZE) {
+			fprintf(stderr, "error: failed to read infile\n");
+			return ERROR_FAILED_TO_READ_INFILE;
+		}
+		read_index(buf, &entries[i]);
+	}
+	return 0;
+}
+
+// 索引をまとめて書く
+static unsigned int write_entries(FILE *out, const container_t *header, const index_t *entries) {
+	uint8_t buf[CONTAINER_INDEX_SIZE];
+	uint64_t i, total = count_chunks(header);
+
+	fseek64(out, (int64_t)index_offset(header), SEEK_SET);
+	for (i=0; i<total; ++i) {
+		write_index(buf, &entries[i]);
+		if (fwrite(buf, 1, CONTAINER_INDEX_SIZE, out) != CONTAINER_INDEX_SIZE) {
+			fprintf(stderr, "\nerror: failed to write outfile\n");
+			return ERROR_FAILED_TO_WRITE_OUTFILE;
+		}
+	}
+	return 0;
+}
+
+
+// 道具をととのえる (鍵は展開したものを借りる)。できなければ 0
+static int open_session(session_t *s, CRYPTK2_KEY key, int batch) {
+	s->key = key;
+	s->old_key = NULL;
+	s->k2b = NULL;
+	s->buf = NULL;
+	s->size = 0;
+	s->batch = batch;
+	return (s->k2 = new_cryptk2()) != NULL;
+}
+
+// 道具を片づける
+static void close_session(session_t *s) {
+	delete_cryptk2(s->k2);
+	delete_cryptk2(s->k2b);
+	s->k2 = s->k2b = NULL;
+	if (s->buf != NULL) {
+		memset(s->buf, 0, s->size);
+		page_free(s->buf);
+	}
+	s->buf = NULL;
+	s->size = 0;
+}
+
+// 道具のバッファーを size バイト以上にする (中身は捨てる)。できなければ NULL
+static uint8_t *session_buffer(session_t *s, size_t size) {
+	if (s->size < size) {
+		if (s->buf != NULL) {
+			memset(s->buf, 0, s->size);
+			page_free(s->buf);
+		}
+		s->size = 0;
+		if ((s->buf = (uint8_t *)page_alloc(size)) == NULL) {
+			return NULL;
+		}
+		s->size = size;
+	}
+	return s->buf;
+}
+
+
+// バッチにファイルを足す (src と dst は malloc したもので、バッチが持つ)
+static unsigned int add_job(batch_t *b, char *src, char *dst, uint64_t size) {
+	job_t *jobs;
+	size_t capacity;
+
+	if (src == NULL || dst == NULL) {
+		goto failed;
+	}
+	if (b->njobs == b->capacity) {
+		capacity = (b->capacity != 0) ? b->capacity * 2 : 256;
+		if ((jobs = (job_t *)realloc(b->jobs, capacity * sizeof(job_t))) == NULL) {
+			goto failed;
+		}
+		b->jobs = jobs;
+		b->capacity = capacity;
+	}
+	b->jobs[b->njobs].src = src;
+	b->jobs[b->njobs].dst = dst;
+	b->jobs[b->njobs].size = size;
+	++b->njobs;
+	return 0;
+
+failed:
+	free(src);
+	free(dst);
+	fprintf(stderr, "error: failed to allocate memory\n");
+	return ERROR_MALLOC_FAILED;
+}
+
+// ディレクトリ src の下のファイルを、dst の下の同じ名前で足す (シンボリックリンクはたどらない)
+static unsigned int add_dir(batch_t *b, const char *src, const char *dst) {
+	char *from, *to;
+	unsigned int err=0;
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE h;
+	char *pattern;
+
+	if ((pattern = join_path(src, "*")) == NULL) {
+		fprintf(stderr, "error: failed to allocate memory\n");
+		return ERROR_MALLOC_FAILED;
+	}
+	h = FindFirstFileA(pattern, &found);
+	free(pattern);
+	if (h == INVALID_HANDLE_VALUE) {
+		fprintf(stderr, "error: failed to open %s\n", src);
+		return ERROR_FAILED_TO_OPEN_INFILE;
+	}
+	do {
+		if (!strcmp(found.cFileName, ".") || !strcmp(found.cFileName, "..") || (found.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+			continue;
+		}
+		from = join_path(src, found.cFileName);
+		to = join_path(dst, found.cFileName);
+		if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			err = add_job(b, from, to, ((uint64_t)found.nFileSizeHigh << 32) | found.nFileSizeLow);
+			continue;
+		}
+		if (from == NULL || to == NULL) {
+			fprintf(stderr, "error: failed to allocate memory\n");
+			err = ERROR_MALLOC_FAILED;
+		}
+		else {
+			err = add_dir(b, from, to);
+		}
+		free(from);
+		free(to);
+	} while (!err && FindNextFileA(h, &found));
+	FindClose(h);
+#else
+	DIR *dir;
+	struct dirent *entry;
+	struct stat st;
+
+	if ((dir = opendir(src)) == NULL) {
+		fprintf(stderr, "error: failed to open %s\n", src);
+		return ERROR_FAILED_TO_OPEN_INFILE;
+	}
+	while (!err && (entry = readdir(dir)) != NULL) {
+		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+			continue;
+		}
+		from = join_path(src, entry->d_name);
+		to = join_path(dst, entry->d_name);
+		if (from == NULL || to == NULL) {
+			fprintf(stderr, "error: failed to allocate memory\n");
+			err = ERROR_MALLOC_FAILED;
+		}
+		else if (lstat(from, &st) != 0) {
+			// 読めないものは飛ばす
+		}
+		else if (S_ISREG(st.st_mode)) {
+			err = add_job(b, from, to, (uint64_t)st.st_size);
+			continue;
+		}
+		else if (S_ISDIR(st.st_mode)) {
+			err = add_dir(b, from, to);
+		}
+		// ふつうのファイルとディレクトリのほかは飛ばす
+		free(from);
+		free(to);
+	}
+	closedir(dir);
+#endif
+	return err;
+}
+
+// リスト list のファイル (1 行にひとつ) を、dst の下の同じ相対パスで足す
+// 絶対パスは先頭の区切り (とドライブ) を外して相対パスにする。".." で dst の外に出るものはエラー。
+static unsigned int add_list(batch_t *b, const char *list, const char *dst) {
+	FILE *f;
+	char line[4096], *rel, *p;
+	size_t n;
+	uint64_t size;
+	unsigned int err=0;
+
+	if ((f = fopen(list, "r")) == NULL) {
+		fprintf(stderr, "error: failed to open infile\n");
+		return ERROR_FAILED_TO_OPEN_INFILE;
+	}
+	while (!err && fgets(line, sizeof(line), f) != NULL) {
+		// 行末の改行を外す (長すぎる行はエラー)
+		n = strlen(line);
+		if (n > 0 && line[n - 1] != '\n' && !feof(f)) {
+			fprintf(stderr, "error: too long line in %s\n", list);
+			err = ERROR_INVALID_INFILE;
+			break;
+		}
+		while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) {
+			line[--n] = '\0';
+		}
+		if (n == 0) {
+			continue;
+		}
+
+		// 出力先の相対パス
+		rel = line;
+#ifdef _WIN32
+		if (((rel[0] >= 'A' && rel[0] <= 'Z') || (rel[0] >= 'a' && rel[0] <= 'z')) && rel[1] == ':') {
+			rel += 2;
+		}
+#endif
+		while (is_separator(*rel)) {
+			++rel;
+		}
+		for (p=rel; *p; ) {
+			if (p[0] == '.' && p[1] == '.' && (p[2] == '\0' || is_separator(p[2]))) {
+				fprintf(stderr, "error: %s is outside of outfile\n", line);
+				err = ERROR_INVALID_INFILE;
+				break;
+			}
+			while (*p && !is_separator(*p)) ++p;
+			while (is_separator(*p)) ++p;
+		}
+		if (err) {
+			break;
+		}
+
+		// ファイルでなければ飛ばす
+		if (path_info(line, &size) != 1) {
+			fprintf(stderr, "warning: skipping %s\n", line);
+			continue;
+		}
+		if ((p = (char *)malloc(n + 1)) != NULL) {
+			memcpy(p, line, n + 1);
+		}
+		err = add_job(b, p, join_path(dst, rel), size);
+	}
+	fclose(f);
+	return err;
+}
+
+// 大きいファイルから (同じ大きさなら名前の順)
+static int compare_jobs(const void *a, const void *b) {
+	const job_t *x = (const job_t *)a, *y = (const job_t *)b;
+
+	if (x->size != y->size) {
+		return (x->size < y->size) ? 1 : -1;
+	}
+	return strcmp(x->src, y->src);
+}
+
+// バッチのスレッドたちを起こす (乱数と CPU に合わせた処理の選択は、その前に済ませておく)
+// 起きたスレッドの数を返す。
+static unsigned int start_batch(batch_t *b, thread_t *threads) {
+	unsigned int nthreads, i;
+
+	if (b->mode == MODE_ENCRYPT) {
+		open_random();
+	}
+	cryptk2_get_backend();
+	mutex_init(&b->lock);
+	cond_init(&b->queued);
+
+	// 見張りでなければ、ファイルの数より多くは要らない
+	nthreads = count_threads();
+	if (!b->watching && nthreads > b->njobs) {
+		nthreads = (unsigned int)b->njobs;
+	}
+	for (i=0; i<nthreads; ++i) {
+		if (!thread_create(&threads[i], batch_main, b)) break;
+	}
+	return i;
+}
+
+// バッチのスレッドたちに終わりの合図をして、キューが片づくのを待つ
+static void stop_batch(batch_t *b, thread_t *threads, unsigned int nthreads) {
+	unsigned int i;
+
+	mutex_lock(&b->lock);
+	b->closing = 1;
+	cond_broadcast(&b->queued);
+	mutex_unlock(&b->lock);
+
+	for (i=0; i<nthreads; ++i) {
+		thread_join(threads[i]);
+	}
+	cond_free(&b->queued);
+	mutex_free(&b->lock);
+}
+
+// バッチのスレッドの本体: 残っているいちばん大きいファイル (見張りでは来た順) を取っては暗号化 (復号化)
+static THREAD_PROC batch_main(void *arg) {
+	batch_t *b = (batch_t *)arg;
+	session_t s;
+	job_t job;
+	unsigned int err;
+
+	// バッファーははじめからチャンクの大きさで
+	if (!open_session(&s, b->key, 1) || session_buffer(&s, options.chunk_size) == NULL) {
+		close_session(&s);
+		return THREAD_RETURN;
+	}
+	for (;;) {
+		mutex_lock(&b->lock);
+		while (b->watching && !b->closing && b->next >= b->njobs) {
+			cond_wait(&b->queued, &b->lock);
+		}
+		if (b->next >= b->njobs) {
+			mutex_unlock(&b->lock);
+			break;
+		}
+		job = b->jobs[b->next++];
+		if (b->next == b->njobs) {
+			b->next = b->njobs = 0;
+		}
+		mutex_unlock(&b->lock);
+
+		make_dirs(job.dst);
+		err = (b->mode == MODE_ENCRYPT) ? encrypt_file(job.src, job.dst, &s) : decrypt_file(job.src, job.dst, &s);
+
+		mutex_lock(&b->lock);
+		if (err) {
+			fprintf(stderr, "\nerror: %s failed\n", job.src);
+			++b->failed;
+			if (!b->err) b->err = err;
+		}
+#ifdef CRYPTOR_WATCH
+		// 見張り: 見つけてから書き終わるまで
+		if (b->watching) {
+			uint64_t latency = now_us() - job.queued;
+			unsigned int bucket;
+
+			for (bucket=0; bucket<LATENCY_BUCKETS-1 && (latency >> bucket) > 1; ++bucket);
+			++b->latency[bucket];
+			b->latency_sum += latency;
+			if (latency > b->latency_max) {
+				b->latency_max = latency;
+			}
+			++b->done;
+			mutex_unlock(&b->lock);
+			free(job.src);
+			free(job.dst);
+			continue;
+		}
+#endif
+
+		// パーセント表示 (ファイルの数で、変わったときだけ)
+		++b->done;
+		if ((unsigned int)(b->done * 100 / b->total) != b->percent) {
+			b->percent = (unsigned int)(b->done * 100 / b->total);
+			fprintf(stderr, "\r%s (%3u %%) ...", (b->mode == MODE_ENCRYPT) ? "encrypting" : "decrypting", b->percent);
+		}
+		mutex_unlock(&b->lock);
+		free(job.src);
+		free(job.dst);
+	}
+	close_session(&s);
+	return THREAD_RETURN;
+}
+
+
+#ifdef CRYPTOR_WATCH
+// 見張りを止める合図を受ける
+static void watch_signal(int sig) {
+	(void)sig;
+	watch_stop = 1;
+}
+
+// いまの時刻 (マイクロ秒、戻らない時計で)
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// ファイルひとつにかかった時間の分布
+static void print_latency(const batch_t *b) {
+	unsigned int i;
+	uint64_t n = 0;
+
+	for (i=0; i<LATENCY_BUCKETS; ++i) {
+		n += b->latency[i];
+	}
+	if (n == 0) {
+		return;
+	}
+	fprintf(stderr, "latency per file: average %llu us, max %llu us\n", (unsigned long long)(b->latency_sum / n), (unsigned long long)b->latency_max);
+	for (i=0; i<LATENCY_BUCKETS; ++i) {
+		if (b->latency[i] != 0) {
+			fprintf(stderr, "  < %12llu us: %llu\n", (unsigned long long)2 << i, (unsigned long long)b->latency[i]);
+		}
+	}
+}
+#endif
+
+
+// スレッドの数 (--threads がなければ、使える CPU の数)
+static unsigned int count_threads(void) {
+	unsigned int n;
+
+	if (options.threads != 0) {
+		return options.threads;
+	}
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	n = (unsigned int)info.dwNumberOfProcessors;
+#else
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	n = (cpus > 0) ? (unsigned int)cpus : 1;
+#endif
+	if (n < 1) n = 1;
+	if (n > MAX_THREADS) n = MAX_THREADS;
+	return n;
+}
+
+
+// "123"、"64K"、"1M" のようなサイズを読む
+static int parse_size(const char *str, uint64_t *value) {
+	char *end;
+	unsigned long long n;
+
+	if (*str < '0' || *str > '9') {
+		return 0;
+	}
+	n = strtoull(str, &end, 10);
+	if ((*end == 'K' || *end == 'k') && n <= (~0ull >> 10)) {
+		n <<= 10;
+		++end;
+	}
+	else if ((*end == 'M' || *end == 'm') && n <= (~0ull >> 20)) {
+		n <<= 20;
+		++end;
+	}
+	if (*end != '\0') {
+		return 0;
+	}
+	*value = (uint64_t)n;
+	return 1;
+}
+
+// ページ境界にそろえたメモリー (page_free で返す)
+static void *page_alloc(size_t size) {
+#ifdef _WIN32
+	return _aligned_malloc(size, PAGE_SIZE);
+#else
+	void *p;
+	return (posix_memalign(&p, PAGE_SIZE, size) == 0) ? p : NULL;
+#endif
+}
+
+
+// count 個ぶんの size バイトを bytes に。あふれれば 0 を返す
+static int mul_size(size_t count, size_t size, size_t *bytes) {
+	if (size != 0 && count > SIZE_MAX / size) {
+		return 0;
+	}
+	*bytes = count * size;
+	return 1;
+}
+
+
+// パスがあるか。ふつうのファイルなら 1 (size に大きさ)、ディレクトリなら 2、なければ 0
+static int path_info(const char *path, uint64_t *size) {
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) {
+		return 0;
+	}
+	if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+		return 2;
+	}
+	*size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	return 1;
+#else
+	struct stat st;
+	if (stat(path, &st) != 0) {
+		return 0;
+	}
+	if (S_ISDIR(st.st_mode)) {
+		return 2;
+	}
+	*size = (uint64_t)st.st_size;
+	return S_ISREG(st.st_mode) ? 1 : 0;
+#endif
+}
+
+// dir と name をつなげたパス (free で返す)
+static char *join_path(const char *dir, const char *name) {
+	size_t n = strlen(dir), m = strlen(name);
+	char *path;
+
+	if ((path = (char *)malloc(n + m + 2)) == NULL) {
+		return NULL;
+	}
+	memcpy(path, dir, n);
+	if (n > 0 && !is_separator(dir[n - 1])) {
+		path[n++] = PATH_SEPARATOR;
+	}
+	memcpy(path + n, name, m + 1);
+	return path;
+}
+
+// path のファイルを置くディレクトリをつくる (もうあればそのまま。できなくても、開くときにわかる)
+static void make_dirs(const char *path) {
+	size_t n = strlen(path), i;
+	char *dir;
+
+	if ((dir = (char *)malloc(n + 1)) == NULL) {
+		return;
+	}
+	memcpy(dir, path, n + 1);
+	for (i=1; i<n; ++i) {
+		if (is_separator(dir[i]) && !is_separator(dir[i - 1])) {
+			dir[i] = '\0';
+#ifdef _WIN32
+			_mkdir(dir);
+#else
+			mkdir(dir, 0777);
+#endif
+			dir[i] = path[i];
+		}
+	}
+	free(dir);
+}
+
+
+// ファイルを開く ("-" なら標準入力か標準出力)
+static FILE *open_file(const char *filename, const char *mode) {
+	FILE *f;
+
+	if (strcmp(filename, "-")) {
+		return fopen(filename, mode);
+	}
+	f = (mode[0] == 'r') ? stdin : stdout;
+#ifdef _WIN32
+	_setmode(_fileno(f), _O_BINARY);
+#endif
+	return f;
+}
+
+// ファイルを閉じる (標準入出力は書き出すだけ)。失敗すれば 0 以外
+static int close_file(FILE *f) {
+	if (f == stdin) {
+		return 0;
+	}
+	if (f == stdout) {
+		return fflush(f);
+	}
+	return fclose(f);
+}
+
+// path の隣に、ほかと重ならない名前の一時ファイルをつくって読み書き両用で開く。できなければ NULL。
+// 名前は *name に (malloc したもの)。POSIX では like のモードと持ち主を写す
+// (Windows では置き換えるときに ReplaceFile が元の属性とアクセス権を残す)。
+static FILE *open_temp(const char *path, FILE *like, char **name) {
+	FILE *f;
+#ifdef _WIN32
+	char dir[MAX_PATH];
+	size_t len;
+
+	// ディレクトリの部分 (なければカレントディレクトリ)
+	for (len=strlen(path); len>0 && path[len - 1] != '\\' && path[len - 1] != '/' && path[len - 1] != ':'; --len);
+	if (len >= MAX_PATH - 14 || (*name = (char *)malloc(MAX_PATH)) == NULL) {
+		return NULL;
+	}
+	if (len == 0) {
+		strcpy(dir, ".");
+	}
+	else {
+		memcpy(dir, path, len);
+		dir[len] = '\0';
+	}
+	(void)like;
+
+	// GetTempFileName は空のファイルをつくるので、それを開きなおす
+	if (!GetTempFileNameA(dir, "ck2", 0, *name)) {
+		free(*name);
+		*name = NULL;
+		return NULL;
+	}
+	if ((f = fopen(*name, "w+b")) == NULL) {
+		remove(*name);
+		free(*name);
+		*name = NULL;
+	}
+	return f;
+#else
+	struct stat st;
+	int fd;
+
+	if ((*name = (char *)malloc(strlen(path) + 8)) == NULL) {
+		return NULL;
+	}
+	strcpy(*name, path);
+	strcat(*name, ".XXXXXX");
+	if ((fd = mkstemp(*name)) < 0) {
+		free(*name);
+		*name = NULL;
+		return NULL;
+	}
+
+	// 持ち主を写せなくても (root でなければふつう)、モードは写す
+	if (fstat(fileno(like), &st) == 0) {
+		if (fchown(fd, st.st_uid, st.st_gid) != 0) {
+			st.st_mode &= ~(mode_t)(S_ISUID | S_ISGID);
+		}
+		fchmod(fd, st.st_mode & 07777);
+	}
+	if ((f = fdopen(fd, "w+b")) == NULL) {
+		close(fd);
+		remove(*name);
+		free(*name);
+		*name = NULL;
+	}
+	return f;
+#endif
+}
+
+// ファイルサイズ
+static int get_size(FILE *f, int64_t *size) {
+#ifdef _WIN32
+	return !fseek64(f, 0, SEEK_END) && (*size = ftell64(f)) >= 0;
+#else
+	struct stat st;
+	if (fstat(fileno(f), &st) != 0) {
+		return 0;
+	}
+	*size = (int64_t)st.st_size;
+	return 1;
+#endif
+}
+
+// offset から len バイト読む (POSIX は pread で、f の位置は変えない。標準入力は offset によらず続きを)
+static int read_at(FILE *f, uint64_t offset, uint8_t *buf, size_t len) {
+	if (f == stdin) {
+		return fread(buf, 1, len, f) == len;
+	}
+#ifdef _WIN32
+	return !fseek64(f, (int64_t)offset, SEEK_SET) && fread(buf, 1, len, f) == len;
+#else
+	ssize_t n;
+	while (len > 0) {
+		if ((n = pread(fileno(f), buf, len, (off_t)offset)) <= 0) {
+			if (n < 0 && errno == EINTR) continue;
+			return 0;
+		}
+		buf += n;
+		len -= (size_t)n;
+		offset += (uint64_t)n;
+	}
+	return 1;
+#endif
+}
+
+// offset に len バイト書く (POSIX は pwrite で、f の位置は変えない。標準出力は offset によらず続きに)
+static int write_at(FILE *f, uint64_t offset, const uint8_t *buf, size_t len) {
+	if (f == stdout) {
+		return fwrite(buf, 1, len, f) == len;
+	}
+#ifdef _WIN32
+	return !fseek64(f, (int64_t)offset, SEEK_SET) && fwrite(buf, 1, len, f) == len;
+#else
+	ssize_t n;
+	while (len > 0) {
+		if ((n = pwrite(fileno(f), buf, len, (off_t)offset)) <= 0) {
+			if (n < 0 && errno == EINTR) continue;
+			return 0;
+		}
+		buf += n;
+		len -= (size_t)n;
+		offset += (uint64_t)n;
+	}
+	return 1;
+#endif
+}
+
+// 前から順に読むと OS に伝える
+static void advise_sequential(FILE *f) {
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+	if (f == stdin) return;
+	posix_fadvise(fileno(f), 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+	(void)f;
+#endif
+}
+
+// 書く前に場所を取っておく (サイズは変えない。できなくてもかまわない)
+static void preallocate(FILE *f, uint64_t len) {
+#ifdef __linux__
+	if (len > 0 && f != stdout) {
+		fallocate(fileno(f), FALLOC_FL_KEEP_SIZE, 0, (off_t)len);
+	}
+#else
+	(void)f;
+	(void)len;
+#endif
+}
+
+// 書いたところをディスクに書き出し始める
+static void start_writeback(FILE *f, uint64_t offset, uint64_t len) {
+#ifdef __linux__
+	if (f == stdout) return;
+	sync_file_range(fileno(f), (off_t)offset, (off_t)len, SYNC_FILE_RANGE_WRITE);
+#else
+	(void)f;
+	(void)offset;
+	(void)len;
+#endif
+}
+
+// もう使わないところをページキャッシュから外す (written なら書き出しを待ってから)
+// 何 GB も流すときに、ほかのプログラムのキャッシュを追い出さないように。
+static void drop_cache(FILE *f, uint64_t offset, uint64_t len, int written) {
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+	if (f == stdin || f == stdout) return;
+#  ifdef __linux__
+	if (written) {
+		sync_file_range(fileno(f), (off_t)offset, (off_t)len, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+	}
+#  else
+	(void)written;
+#  endif
+	posix_fadvise(fileno(f), (off_t)offset, (off_t)len, POSIX_FADV_DONTNEED);
+#else
+	(void)f;
+	(void)offset;
+	(void)len;
+	(void)written;
+#endif
+}
+
+// ファイルの先頭から size バイトをマップする (writable なら size まで伸ばしてから)
+static int map_file(map_t *m, FILE *f, uint64_t size, int writable) {
+	int64_t current;
+
+	m->ptr = NULL;
+	m->size = (size_t)size;
+	if ((uint64_t)m->size != size || size == 0) {
+		return 0;
+	}
+	if (writable && (!get_size(f, &current) || ((uint64_t)current < size && truncate64(f, size)))) {
+		return 0;
+	}
+
+#ifdef _WIN32
+	m->mapping = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(f)), NULL, writable ? PAGE_READWRITE : PAGE_READONLY, (DWORD)(size >> 32), (DWORD)size, NULL);
+	if (m->mapping == NULL) {
+		return 0;
+	}
+	if ((m->ptr = (uint8_t *)MapViewOfFile(m->mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, m->size)) == NULL) {
+		CloseHandle(m->mapping);
+		return 0;
+	}
+#else
+	void *p = mmap(NULL, m->size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fileno(f), 0);
+	if (p == MAP_FAILED) {
+		return 0;
+	}
+	m->ptr = (uint8_t *)p;
+
+	// 前から順に読み書きする。大きなページも使えるなら
+	madvise(p, m->size, MADV_SEQUENTIAL);
+#  ifdef MADV_HUGEPAGE
+	madvise(p, m->size, MADV_HUGEPAGE);
+#  endif
+#endif
+	return 1;
+}
+
+// マップを外す (マップしていなければ何もしない)
+static void unmap_file(map_t *m) {
+	if (m->ptr == NULL) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(m->ptr);
+	CloseHandle(m->mapping);
+#else
+	munmap(m->ptr, m->size);
+#endif
+	m->ptr = NULL;
+}
+
+
+// 読むスレッドと暗号化するスレッドたちを起こす
+static int start_pipeline(pipeline_t *p, unsigned int nthreads) {
+	uint64_t i;
+
+	mutex_init(&p->lock);
+	cond_init(&p->filled);
+	cond_init(&p->crypted);
+	cond_init(&p->freed);
+	p->nread = p->ncrypt = p->nwritten = 0;
+	p->quit = 0;
+	p->err = 0;
+	p->reading = 0;
+	p->eof = 0;
+
+	// マップしたときは、どのチャンクもはじめから読み終わっている
+	if (p->mapped) {
+		for (i=0; i<p->total; ++i) {
+			prepare_chunk(p, &p->slots[i], i);
+		}
+		p->nread = p->total;
+		p->eof = 1;
+	}
+
+	for (i=0; i<nthreads; ++i) {
+		if (!thread_create(&p->threads[i], worker_main, p)) break;
+	}
+	p->nthreads = i;
+
+	// 暗号化するスレッドがひとつも起きないか、読むスレッドが起きなければ失敗
+	if (i == 0 || (!p->mapped && !(p->reading = thread_create(&p->reader, reader_main, p)))) {
+		stop_pipeline(p);
+		return 0;
+	}
+	return 1;
+}
+
+// 次に書くチャンク (チャンクの順) を待つ。全部書き終わったか、読むのに失敗したか、止められていれば NULL
+static chunk_t *next_chunk(pipeline_t *p) {
+	chunk_t *chunk = &p->slots[p->nwritten % p->depth];
+
+	mutex_lock(&p->lock);
+	while (!(p->nwritten < p->nread && chunk->done) && !p->quit && !((p->err || p->eof) && p->nwritten >= p->nread)) {
+		cond_wait(&p->crypted, &p->lock);
+	}
+	if (!(p->nwritten < p->nread && chunk->done)) {
+		chunk = NULL;
+	}
+	mutex_unlock(&p->lock);
+	return chunk;
+}
+
+// 書き終わったバッファーを読むスレッドに返す
+static void release_chunk(pipeline_t *p) {
+	mutex_lock(&p->lock);
+	++p->nwritten;
+	cond_broadcast(&p->freed);
+	mutex_unlock(&p->lock);
+}
+
+// スレッドたちを止める
+static void stop_pipeline(pipeline_t *p) {
+	unsigned int i;
+
+	mutex_lock(&p->lock);
+	p->quit = 1;
+	cond_broadcast(&p->filled);
+	cond_broadcast(&p->freed);
+	mutex_unlock(&p->lock);
+
+	if (p->reading) {
+		thread_join(p->reader);
+		p->reading = 0;
+	}
+	for (i=0; i<p->nthreads; ++i) {
+		thread_join(p->threads[i]);
+	}
+	p->nthreads = 0;
+
+	cond_free(&p->filled);
+	cond_free(&p->crypted);
+	cond_free(&p->freed);
+	mutex_free(&p->lock);
+}
+
+// 読むスレッドの本体: 空いたバッファーにチャンクを順に読む
+static THREAD_PROC reader_main(void *arg) {
+	pipeline_t *p = (pipeline_t *)arg;
+	const container_t *header = p->header;
+	chunk_t *chunk;
+	uint64_t index;
+	int64_t n = 0;
+
+	for (index=0; index<p->total; ++index) {
+		// バッファーが空くのを待つ
+		mutex_lock(&p->lock);
+		while (!p->quit && index >= p->nwritten + p->depth) {
+			cond_wait(&p->freed, &p->lock);
+		}
+		if (p->quit) {
+			mutex_unlock(&p->lock);
+			break;
+		}
+		mutex_unlock(&p->lock);
+
+		chunk = &p->slots[index % p->depth];
+		prepare_chunk(p, chunk, index);
+
+		// ファイル in から読み込み (サイズのわからないストリームは、読めたぶんだけ)
+		if (p->unknown) {
+			if ((n = read_stream(p, chunk->buf, chunk->len)) >= 0) {
+				chunk->len = (size_t)n;
+			}
+		}
+		else if (!read_at(p->in, p->in_base + index * header->chunk_size, chunk->buf, chunk->len)) {
+			n = -1;
+		}
+		if (n < 0) {
+			fprintf(stderr, "\nerror: failed to read infile\n");
+			mutex_lock(&p->lock);
+			p->err = ERROR_FAILED_TO_READ_INFILE;
+			cond_broadcast(&p->crypted);
+			mutex_unlock(&p->lock);
+			break;
+		}
+
+		// 終わりまで読んだ
+		if (p->unknown && n == 0) {
+			break;
+		}
+
+		mutex_lock(&p->lock);
+		++p->nread;
+		cond_broadcast(&p->filled);
+		mutex_unlock(&p->lock);
+
+		if (p->unknown && (size_t)n < header->chunk_size) {
+			break;
+		}
+	}
+
+	// 書くスレッドに、もう読まないと伝える
+	mutex_lock(&p->lock);
+	p->eof = 1;
+	cond_broadcast(&p->crypted);
+	mutex_unlock(&p->lock);
+	return THREAD_RETURN;
+}
+
+// 暗号化するスレッドの本体: 読み終わったチャンクを取っては暗号化 (復号化、更新)
+static THREAD_PROC worker_main(void *arg) {
+	pipeline_t *p = (pipeline_t *)arg;
+	CRYPTK2 k2 = new_cryptk2();
+	CRYPTK2 k2b = (p->mode == WORK_RECRYPT) ? new_cryptk2() : NULL;
+	chunk_t *chunk;
+
+	mutex_lock(&p->lock);
+
+	// 状態がつくれなければ、全体を止める (暗号化しないまま書かないように)
+	if (k2 == NULL || (p->mode == WORK_RECRYPT && k2b == NULL)) {
+		if (p->err == 0) {
+			fprintf(stderr, "\nerror: failed to allocate memory\n");
+			p->err = ERROR_MALLOC_FAILED;
+		}
+		p->quit = 1;
+		cond_broadcast(&p->filled);
+		cond_broadcast(&p->crypted);
+		cond_broadcast(&p->freed);
+	}
+
+	for (;;) {
+		// 読み終わったチャンクか、終わりの合図を待つ
+		while (!p->quit && p->ncrypt >= p->nread) {
+			cond_wait(&p->filled, &p->lock);
+		}
+		if (p->quit) {
+			break;
+		}
+
+		// チャンクをひとつ取る
+		chunk = &p->slots[p->ncrypt++ % p->depth];
+		mutex_unlock(&p->lock);
+
+		work_chunk(p, k2, k2b, chunk);
+
+		mutex_lock(&p->lock);
+		chunk->done = 1;
+		cond_broadcast(&p->crypted);
+	}
+	mutex_unlock(&p->lock);
+
+	// 暗号ライブラリーお掃除
+	delete_cryptk2(k2);
+	delete_cryptk2(k2b);
+	return THREAD_RETURN;
+}
+
+// ストリームから len バイトまで読む (復号化では、そのあとに終わりのぶんを残して)。
+// 先に読んでおいたぶんから続けて、読めたバイト数を返す。終わりなら 0、読めなければ -1
+static int64_t read_stream(pipeline_t *p, uint8_t *buf, size_t len) {
+	size_t n = p->ntail;
+
+	memcpy(buf, p->tail, n);
+	n += fread(buf + n, 1, len + p->lookahead - n, p->in);
+	if (ferror(p->in)) {
+		return -1;
+	}
+
+	// 終わりのぶんもなければ、残りは終わりのほうで確かめる
+	if (n < p->lookahead) {
+		memcpy(p->tail, buf, n);
+		p->ntail = n;
+		return 0;
+	}
+	n -= p->lookahead;
+	memcpy(p->tail, buf + n, p->lookahead);
+	p->ntail = p->lookahead;
+	return (int64_t)n;
+}
+
+// チャンク index を読む前に、バッファーの情報をととのえる
+static void prepare_chunk(pipeline_t *p, chunk_t *chunk, uint64_t index) {
+	const container_t *header = p->header, *old = p->old;
+	uint64_t rest;
+
+	rest = p->unknown ? header->chunk_size : header->size - index * header->chunk_size;
+	chunk->index = index;
+	chunk->len = (rest < header->chunk_size) ? (size_t)rest : header->chunk_size;
+	if (p->entries != NULL) {
+		chunk->entry = p->entries[index];
+	}
+	else {
+		chunk->entry.generation = 0;
+		chunk->entry.nonce = 0;
+		chunk->entry.digest = 0;
+	}
+	chunk->dirty = 0;
+	chunk->done = 0;
+
+	// 更新: 前と同じ長さのチャンクなら比べられる
+	chunk->known = 0;
+	if (old != NULL && index < count_chunks(old)) {
+		rest = old->size - index * old->chunk_size;
+		chunk->known = (((rest < old->chunk_size) ? rest : old->chunk_size) == chunk->len);
+	}
+}
+
+// チャンクひとつぶんの仕事 (k2b は鍵の取り替えで元の鍵に使う状態)
+static void work_chunk(pipeline_t *p, CRYPTK2 k2, CRYPTK2 k2b, chunk_t *chunk) {
+	const container_t *header = p->header;
+	uint64_t digest = 0;
+	uint8_t iv[16];
+
+	// 鍵の取り替え: 元の鍵ストリームと新しい鍵ストリームを一度に XOR する (平文はバッファーに残らない)
+	if (p->mode == WORK_RECRYPT) {
+		chunk_iv(p->old, chunk->index, chunk->entry.nonce, iv);
+		cryptk2_setup_iv(k2b, p->old_key, iv);
+		chunk_iv(header, chunk->index, 0, iv);
+		cryptk2_setup_iv(k2, p->key, iv);
+		cryptk2_recrypt(k2b, k2, chunk->len, chunk->src, chunk->buf);
+
+		// 索引のダイジェストは平文のものなので、マスクだけかけなおす
+		if (header->flags & CONTAINER_FLAG_INDEX) {
+			chunk->entry.digest ^= chunk_mask(k2b, p->old_key, p->old, chunk->index, chunk->entry.nonce) ^ chunk_mask(k2, p->key, header, chunk->index, 0);
+		}
+		chunk->entry.generation = 0;
+		chunk->entry.nonce = 0;
+		return;
+	}
+
+	// 暗号化前のダイジェスト
+	if (p->mode != WORK_DECRYPT) {
+		digest = chunk_digest(chunk->src, chunk->len);
+
+		// 更新: 前と同じ内容ならそのまま
+		if (p->mode == WORK_UPDATE && chunk->known && (digest ^ chunk_mask(k2, p->key, header, chunk->index, chunk->entry.nonce)) == chunk->entry.digest) {
+			return;
+		}
+
+		// いまの世代で、更新なら新しいノンスで暗号化する
+		chunk->entry.generation = header->generation;
+		chunk->entry.nonce = (p->mode == WORK_UPDATE) ? new_nonce() : 0;
+		chunk->dirty = 1;
+	}
+
+	// チャンクごとの IV で、チャンクの先頭から
+	chunk_iv(header, chunk->index, chunk->entry.nonce, iv);
+	cryptk2_setup_iv(k2, p->key, iv);
+	cryptk2_crypt(k2, chunk->len, chunk->src, chunk->buf);
+
+	if (p->mode != WORK_DECRYPT) {
+		// 索引にはマスクして書く
+		chunk->entry.digest = digest ^ chunk_mask(k2, p->key, header, chunk->index, chunk->entry.nonce);
+	}
+	else if (header->flags & CONTAINER_FLAG_INDEX) {
+		// 復号化: 索引と確かめる (あとで比べられるように、マスクしたダイジェストを残す)
+		digest = chunk_digest(chunk->buf, chunk->len) ^ chunk_mask(k2, p->key, header, chunk->index, chunk->entry.nonce);
+		chunk->dirty = (digest != chunk->entry.digest);
+		chunk->entry.digest = digest;
+	}
+}
+
+
+#ifdef CRYPTOR_IO_URING
+// io_uring で読み書きして、チャンクを暗号化 (復号化、更新) する。
+// スレッドごとに io_uring と登録したバッファーを持ち、depth 個の読み書きを出したままにする。
+// エラー番号を返す。io_uring が使えなければ -1 (まだ何も読み書きしていない)。
+static int run_uring(pipeline_t *p, unsigned int nthreads, size_t depth, size_t stride, const char *label) {
+	uring_t *u;
+	struct iovec *iov;
+	unsigned int i, started, percent;
+	size_t j, bytes;
+	int ok = 1;
+
+	// スレッドひとつあたりのバッファーの数
+	if (nthreads > p->total) {
+		nthreads = (unsigned int)p->total;
+	}
+	depth = (depth + nthreads - 1) / nthreads;
+
+	if ((u = (uring_t *)calloc(nthreads, sizeof(uring_t))) == NULL || (iov = (struct iovec *)malloc(depth * sizeof(struct iovec))) == NULL) {
+		free(u);
+		return -1;
+	}
+
+	// io_uring をつくってバッファーを登録する (どれかひとつでもだめなら使わない)
+	for (i=0; i<nthreads; ++i) {
+		u[i].ring.fd = -1;
+	}
+	for (i=0; i<nthreads && ok; ++i) {
+		u[i].p = p;
+		u[i].id = i;
+		u[i].n = nthreads;
+		u[i].depth = depth;
+		u[i].stride = stride;
+		u[i].slots = (io_slot_t *)calloc(depth, sizeof(io_slot_t));
+		u[i].memory = mul_size(depth, stride, &bytes) ? (uint8_t *)page_alloc(bytes) : NULL;
+		ok = (u[i].slots != NULL && u[i].memory != NULL && ring_setup(&u[i].ring, (unsigned int)depth));
+		for (j=0; ok && j<depth; ++j) {
+			u[i].slots[j].chunk.src = u[i].slots[j].chunk.buf = u[i].memory + j * stride;
+			iov[j].iov_base = u[i].slots[j].chunk.buf;
+			iov[j].iov_len = stride;
+		}
+		ok = ok && syscall(__NR_io_uring_register, u[i].ring.fd, IORING_REGISTER_BUFFERS, iov, (unsigned int)depth) == 0;
+	}
+
+	mutex_init(&p->lock);
+	cond_init(&p->crypted);
+	p->nwritten = 0;
+	p->quit = 0;
+	p->err = 0;
+	p->running = 0;
+
+	// スレッドを起こす
+	for (started=0; ok && started<nthreads; ++started) {
+		mutex_lock(&p->lock);
+		++p->running;
+		mutex_unlock(&p->lock);
+		if (!thread_create(&u[started].thread, uring_main, &u[started])) {
+			// 起きたぶんだけで続ける
+			mutex_lock(&p->lock);
+			--p->running;
+			mutex_unlock(&p->lock);
+			uring_fail(p, ERROR_FAILED_TO_CREATE_THREAD, "failed to create thread", 0);
+			break;
+		}
+	}
+
+	// 終わるまで、パーセント表示
+	mutex_lock(&p->lock);
+	for (percent=101; ok && p->running > 0; ) {
+		if ((unsigned int)(p->nwritten * 100 / p->total) != percent) {
+			percent = (unsigned int)(p->nwritten * 100 / p->total);
+			fprintf(stderr, "\r%s (%3u %%) ...", label, percent);
+		}
+		cond_wait(&p->crypted, &p->lock);
+	}
+	mutex_unlock(&p->lock);
+
+	for (i=0; ok && i<started; ++i) {
+		thread_join(u[i].thread);
+	}
+
+	// お掃除
+	for (i=0; i<nthreads; ++i) {
+		ring_free(&u[i].ring);
+		if (u[i].memory != NULL) {
+			memset(u[i].memory, 0, depth * stride);
+			page_free(u[i].memory);
+		}
+		free(u[i].slots);
+	}
+	cond_free(&p->crypted);
+	mutex_free(&p->lock);
+	free(iov);
+	free(u);
+
+	return ok ? (int)p->err : -1;
+}
+
+// io_uring をつくって、SQ と CQ を mmap する
+static int ring_setup(ring_t *ring, unsigned int entries) {
+	struct io_uring_params params;
+	uint8_t *sq, *cq;
+
+	memset(&params, 0, sizeof(params));
+	if ((ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params)) < 0) {
+		return 0;
+	}
+
+	ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_size > ring->sq_size) {
+			ring->sq_size = ring->cq_size;
+		}
+		ring->cq_size = 0;
+	}
+
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	ring->cq_ptr = (ring->cq_size == 0) ? ring->sq_ptr : mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+	ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sq_ptr == MAP_FAILED || ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED) {
+		return 0;
+	}
+
+	sq = (uint8_t *)ring->sq_ptr;
+	cq = (uint8_t *)ring->cq_ptr;
+	ring->sq_head = (unsigned int *)(sq + params.sq_off.head);
+	ring->sq_tail = (unsigned int *)(sq + params.sq_off.tail);
+	ring->sq_mask = (unsigned int *)(sq + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned int *)(sq + params.sq_off.array);
+	ring->cq_head = (unsigned int *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned int *)(cq + params.cq_off.tail);
+	ring->cq_mask = (unsigned int *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+	ring->pending = 0;
+	return 1;
+}
+
+// io_uring を閉じる (ring_setup が途中で失敗していてもよい)
+static void ring_free(ring_t *ring) {
+	if (ring->fd < 0) {
+		return;
+	}
+	if (ring->sqes != NULL && ring->sqes != MAP_FAILED) {
+		munmap(ring->sqes, ring->sqes_size);
+	}
+	if (ring->cq_size != 0 && ring->cq_ptr != NULL && ring->cq_ptr != MAP_FAILED) {
+		munmap(ring->cq_ptr, ring->cq_size);
+	}
+	if (ring->sq_ptr != NULL && ring->sq_ptr != MAP_FAILED) {
+		munmap(ring->sq_ptr, ring->sq_size);
+	}
+	close(ring->fd);
+	ring->fd = -1;
+}
+
+// 登録したバッファー index への読み書きを SQ に積む
+// (バッファーひとつに読み書きはひとつだけなので、SQ はあふれない)
+static void ring_push(ring_t *ring, int opcode, int fd, uint64_t offset, uint8_t *buf, size_t len, unsigned int index) {
+	unsigned int tail = *ring->sq_tail;
+	unsigned int i = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[i];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = (uint8_t)opcode;
+	sqe->fd = fd;
+	sqe->off = offset;
+	sqe->addr = (uint64_t)(uintptr_t)buf;
+	sqe->len = (uint32_t)len;
+	sqe->buf_index = (uint16_t)index;
+	sqe->user_data = index;
+	ring->sq_array[i] = i;
+
+	// カーネルに見えるのは tail を進めてから
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++ring->pending;
+}
+
+// 積んだ SQE を出して、CQE がひとつ以上届くまで待つ (wait が 0 なら出すだけ)
+static int ring_enter(ring_t *ring, unsigned int wait) {
+	long n;
+
+	for (;;) {
+		n = syscall(__NR_io_uring_enter, ring->fd, ring->pending, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		if (n >= 0) {
+			ring->pending -= (unsigned int)n;
+			return 1;
+		}
+		if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			return 0;
+		}
+	}
+}
+
+// バッファーの残りを読む (書く) SQE を積む
+static void uring_submit(uring_t *u, io_slot_t *slot) {
+	pipeline_t *p = u->p;
+	chunk_t *chunk = &slot->chunk;
+	uint64_t offset = chunk->index * p->header->chunk_size + slot->pos;
+
+	if (slot->state == SLOT_READING) {
+		ring_push(&u->ring, IORING_OP_READ_FIXED, fileno(p->in), p->in_base + offset, chunk->buf + slot->pos, chunk->len - slot->pos, (unsigned int)(slot - u->slots));
+	}
+	else {
+		ring_push(&u->ring, IORING_OP_WRITE_FIXED, fileno(p->out), p->out_base + offset, chunk->buf + slot->pos, chunk->len - slot->pos, (unsigned int)(slot - u->slots));
+	}
+}
+
+// エラーを記録して、ほかのスレッドも止める (表示は最初のエラーだけ)
+static void uring_fail(pipeline_t *p, unsigned int err, const char *message, uint64_t index) {
+	mutex_lock(&p->lock);
+	if (p->err == 0) {
+		p->err = err;
+		if (err == ERROR_CORRUPTED_INFILE) {
+			fprintf(stderr, "\nerror: %s (chunk %llu)\n", message, (unsigned long long)index);
+		}
+		else {
+			fprintf(stderr, "\nerror: %s\n", message);
+		}
+	}
+	p->quit = 1;
+	cond_broadcast(&p->crypted);
+	mutex_unlock(&p->lock);
+}
+
+// io_uring で読み書きするスレッドの本体
+static THREAD_PROC uring_main(void *arg) {
+	uring_t *u = (uring_t *)arg;
+	pipeline_t *p = u->p;
+	const container_t *header = p->header;
+	CRYPTK2 k2 = new_cryptk2();
+	CRYPTK2 k2b = (p->mode == WORK_RECRYPT) ? new_cryptk2() : NULL;
+	struct io_uring_cqe *cqe;
+	io_slot_t *slot;
+	chunk_t *chunk;
+	uint64_t next;
+	unsigned int head;
+	size_t i, inflight = 0;
+	int res, stop = 0;
+
+	// 状態がつくれなければ、何も読まずに全体を止める (暗号化しないまま書かないように)
+	if (k2 == NULL || (p->mode == WORK_RECRYPT && k2b == NULL)) {
+		uring_fail(p, ERROR_MALLOC_FAILED, "failed to allocate memory", 0);
+		stop = 1;
+	}
+
+	for (next=u->id; ; ) {
+		// 空いたバッファーに次のチャンクを読む
+		for (i=0; i<u->depth && !stop && next<p->total; ++i) {
+			slot = &u->slots[i];
+			if (slot->state == SLOT_FREE) {
+				prepare_chunk(p, &slot->chunk, next);
+				slot->state = SLOT_READING;
+				slot->pos = 0;
+				uring_submit(u, slot);
+				++inflight;
+				next += u->n;
+			}
+		}
+		if (inflight == 0) {
+			break;
+		}
+
+		// 出して、どれかが終わるのを待つ
+		if (!ring_enter(&u->ring, 1)) {
+			// 出せなかったものは戻ってこない
+			uring_fail(p, ERROR_FAILED_TO_READ_INFILE, "io_uring_enter failed", 0);
+			break;
+		}
+
+		// 終わったものを順に
+		head = *u->ring.cq_head;
+		while (head != __atomic_load_n(u->ring.cq_tail, __ATOMIC_ACQUIRE)) {
+			cqe = &u->ring.cqes[head & *u->ring.cq_mask];
+			slot = &u->slots[cqe->user_data];
+			res = cqe->res;
+			__atomic_store_n(u->ring.cq_head, ++head, __ATOMIC_RELEASE);
+			chunk = &slot->chunk;
+
+			if (res <= 0 || stop) {
+				if (res <= 0 && !stop) {
+					if (slot->state == SLOT_READING) {
+						uring_fail(p, ERROR_FAILED_TO_READ_INFILE, "failed to read infile", 0);
+					}
+					else {
+						uring_fail(p, ERROR_FAILED_TO_WRITE_OUTFILE, "failed to write outfile", 0);
+					}
+					stop = 1;
+				}
+				slot->state = SLOT_FREE;
+				--inflight;
+				continue;
+			}
+
+			// 途中までなら残りをもう一度
+			slot->pos += (size_t)res;
+			if (slot->pos < chunk->len) {
+				uring_submit(u, slot);
+				continue;
+			}
+
+			if (slot->state == SLOT_READING) {
+				drop_cache(p->in, p->in_base + chunk->index * header->chunk_size, chunk->len, 0);
+
+				// 読み終わったものから暗号化 (復号化、更新)
+				work_chunk(p, k2, k2b, chunk);
+				if (p->entries != NULL) {
+					p->entries[chunk->index] = chunk->entry;
+				}
+
+				// 復号化: 索引のダイジェストと合わない
+				if (p->mode == WORK_DECRYPT && chunk->dirty) {
+					uring_fail(p, ERROR_CORRUPTED_INFILE, "infile is corrupted", chunk->index);
+					stop = 1;
+					slot->state = SLOT_FREE;
+					--inflight;
+					continue;
+				}
+
+				// 書く (更新: 書き直したチャンクだけ)
+				if (p->mode != WORK_UPDATE || chunk->dirty) {
+					slot->state = SLOT_WRITING;
+					slot->pos = 0;
+					uring_submit(u, slot);
+					continue;
+				}
+			}
+			else if (p->mode != WORK_UPDATE) {
+				start_writeback(p->out, p->out_base + chunk->index * header->chunk_size, chunk->len);
+			}
+
+			// このチャンクはおしまい
+			slot->state = SLOT_FREE;
+			--inflight;
+			mutex_lock(&p->lock);
+			++p->nwritten;
+			cond_broadcast(&p->crypted);
+			mutex_unlock(&p->lock);
+		}
+
+		// ほかのスレッドのエラー
+		if (!stop) {
+			mutex_lock(&p->lock);
+			stop = p->quit;
+			mutex_unlock(&p->lock);
+		}
+	}
+
+	mutex_lock(&p->lock);
+	--p->running;
+	cond_broadcast(&p->crypted);
+	mutex_unlock(&p->lock);
+
+	// 暗号ライブラリーお掃除
+	delete_cryptk2(k2);
+	delete_cryptk2(k2b);
+	return THREAD_RETURN;
+}
+#endif
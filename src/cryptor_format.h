@@ -0,0 +1,286 @@
+﻿/**
+ * cryptor のファイル形式 (cryptor と cryptor_reader で共有する)
+ * Written by parly 2015
+ */
+
+#ifndef CRYPTOR_FORMAT_H_
+#define CRYPTOR_FORMAT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "cryptk2.h"
+
+
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#  define inline __inline
+#endif
+
+// 64 ビットのファイル位置
+#ifdef _WIN32
+#  define fseek64 _fseeki64
+#  define ftell64 _ftelli64
+#else
+#  define fseek64 fseeko
+#  define ftell64 ftello
+#endif
+
+
+// v2 形式 (チャンク形式) のヘッダー
+//   0  "CK2C"
+//   4  バージョン (16 ビット) とフラグ (16 ビット)
+//   8  チャンクのサイズ (32 ビット、CONTAINER_MAX_CHUNK_SIZE まで)
+//  12  世代 (更新した回数、32 ビット)
+//  16  暗号化前のファイルサイズ (64 ビット)
+//  24  基準 IV (16 バイト)
+// 数値はすべてビッグエンディアン。ヘッダーのあとに各チャンクの暗号文がすき間なく続く。
+// フラグ CONTAINER_FLAG_INDEX があれば、そのあとにチャンクごとの索引
+//   0  そのチャンクを書いたときの世代 (32 ビット)
+//   4  チャンクの IV のノンス (64 ビット)
+//  12  暗号化前のチャンクのダイジェストをマスクしたもの (64 ビット)
+// が続く (索引にはいつもフラグ CONTAINER_FLAG_NONCE もつける)。ノンスは暗号化したときは 0、
+// 更新で書き直すたびに乱数 (下位 8 ビットは 0)。世代からは決めないので、更新が途中で止まっても、
+// 古いコピーを戻して更新しても、同じ IV にはならない。
+// フラグ CONTAINER_FLAG_STREAM (サイズがわからないまま書いたもの) なら、ヘッダーのサイズは 0 で、
+// 暗号文のあとに
+//   0  暗号化前のファイルサイズ (64 ビット)
+//   8  それをマスクしたもの (64 ビット)
+// が続く。切れたストリームを見つけるため。
+#define CONTAINER_MAGIC "CK2C"
+#define CONTAINER_VERSION 2
+#define CONTAINER_HEADER_SIZE 40
+#define CONTAINER_FLAG_INDEX 0x0001
+#define CONTAINER_FLAG_STREAM 0x0002
+#define CONTAINER_FLAG_NONCE 0x0004
+#define CONTAINER_INDEX_SIZE 20
+#define CONTAINER_FOOTER_SIZE 16
+
+// チャンクの大きさの上限 (32 ビットでもバッファーの大きさがあふれないように)
+#define CONTAINER_MAX_CHUNK_SIZE 0x10000000u
+
+// 大きさのわからないファイル (パイプなど)
+#define CONTAINER_UNKNOWN_SIZE (~(uint64_t)0)
+
+// v2 形式のヘッダー
+typedef struct {
+	uint16_t version;
+	uint16_t flags;
+	uint32_t chunk_size;
+	uint32_t generation;
+	uint64_t size;
+	uint8_t iv[16];
+} container_t;
+
+// 索引のひとつぶん
+typedef struct {
+	uint32_t generation;
+	uint64_t nonce;
+	uint64_t digest;
+} index_t;
+
+
+// チャンクの数
+static inline uint64_t count_chunks(const container_t *header) {
+	return header->size / header->chunk_size + (header->size % header->chunk_size != 0);
+}
+
+// 索引の位置
+static inline uint64_t index_offset(const container_t *header) {
+	return CONTAINER_HEADER_SIZE + header->size;
+}
+
+
+// 先頭 CONTAINER_HEADER_SIZE バイトから v2 形式のヘッダーを読む
+// size はファイル全体の大きさ (わからなければ CONTAINER_UNKNOWN_SIZE で、大きさは確かめない)。
+// v2 形式なら 1、v1 形式なら 0、v2 形式なのにおかしければ -1 を返す。
+static inline int parse_header(const uint8_t *buf, uint64_t size, container_t *header) {
+	int i;
+
+	// マジックが違えば v1 形式
+	if (memcmp(buf, CONTAINER_MAGIC, 4)) {
+		return 0;
+	}
+
+	header->version = (uint16_t)((buf[4] << 8) | buf[5]);
+	header->flags = (uint16_t)((buf[6] << 8) | buf[7]);
+	header->chunk_size = ((uint32_t)buf[8] << 24) | ((uint32_t)buf[9] << 16) | ((uint32_t)buf[10] << 8) | buf[11];
+	header->generation = ((uint32_t)buf[12] << 24) | ((uint32_t)buf[13] << 16) | ((uint32_t)buf[14] << 8) | buf[15];
+	header->size = 0;
+	for (i=0; i<8; ++i) {
+		header->size = (header->size << 8) | buf[16 + i];
+	}
+	memcpy(header->iv, buf + 24, 16);
+
+	// v1 形式の IV がたまたま "CK2C" ではじまることもあるので、バージョンが違えば v1 形式とみなす。
+	// (IV の先頭 6 バイトまで一致するのは 2^48 回に 1 回)
+	if (header->version != CONTAINER_VERSION) {
+		return 0;
+	}
+
+	// チャンクの大きさがおかしいか、知らないフラグ
+	if (header->chunk_size == 0 || header->chunk_size > CONTAINER_MAX_CHUNK_SIZE || (header->flags & ~(CONTAINER_FLAG_INDEX | CONTAINER_FLAG_STREAM | CONTAINER_FLAG_NONCE)) != 0) {
+		return -1;
+	}
+
+	// 索引とノンスはいつもいっしょ
+	if (!(header->flags & CONTAINER_FLAG_NONCE) != !(header->flags & CONTAINER_FLAG_INDEX)) {
+		return -1;
+	}
+
+	// ストリームは索引なしでサイズ 0。大きさがわかれば、そこからサイズを決める
+	if (header->flags & CONTAINER_FLAG_STREAM) {
+		if ((header->flags & CONTAINER_FLAG_INDEX) || header->size != 0) {
+			return -1;
+		}
+		if (size != CONTAINER_UNKNOWN_SIZE) {
+			if (size < CONTAINER_HEADER_SIZE + CONTAINER_FOOTER_SIZE) {
+				return -1;
+			}
+			header->size = size - CONTAINER_HEADER_SIZE - CONTAINER_FOOTER_SIZE;
+		}
+		return 1;
+	}
+
+	// 切れたファイル
+	if (size != CONTAINER_UNKNOWN_SIZE) {
+		if (header->size > size - CONTAINER_HEADER_SIZE) {
+			return -1;
+		}
+		if (size - CONTAINER_HEADER_SIZE - header->size != ((header->flags & CONTAINER_FLAG_INDEX) ? count_chunks(header) * CONTAINER_INDEX_SIZE : 0)) {
+			return -1;
+		}
+	}
+
+	return 1;
+}
+
+// v2 形式のヘッダーを読む (size はファイル全体の大きさ)
+// v2 形式なら 1、v1 形式なら 0、v2 形式なのにおかしければ -1 を返す。
+static inline int read_header(FILE *in, uint64_t size, container_t *header) {
+	uint8_t buf[CONTAINER_HEADER_SIZE];
+
+	// ヘッダーの大きさもなければ v1 形式
+	if (size < CONTAINER_HEADER_SIZE || fread(buf, 1, CONTAINER_HEADER_SIZE, in) != CONTAINER_HEADER_SIZE) {
+		return 0;
+	}
+	return parse_header(buf, size, header);
+}
+
+
+// v2 形式のヘッダーを書く
+static inline void write_header(FILE *out, const container_t *header) {
+	uint8_t buf[CONTAINER_HEADER_SIZE];
+	int i;
+
+	memset(buf, 0, sizeof(buf));
+	memcpy(buf, CONTAINER_MAGIC, 4);
+	buf[4] = (uint8_t)(header->version >> 8);
+	buf[5] = (uint8_t)header->version;
+	buf[6] = (uint8_t)(header->flags >> 8);
+	buf[7] = (uint8_t)header->flags;
+	for (i=0; i<4; ++i) {
+		buf[8 + i] = (uint8_t)(header->chunk_size >> (24 - 8 * i));
+		buf[12 + i] = (uint8_t)(header->generation >> (24 - 8 * i));
+	}
+	for (i=0; i<8; ++i) {
+		buf[16 + i] = (uint8_t)(header->size >> (56 - 8 * i));
+	}
+	memcpy(buf + 24, header->iv, 16);
+
+	fwrite(buf, 1, CONTAINER_HEADER_SIZE, out);
+}
+
+
+// チャンクの IV = 基準 IV の後ろ 8 バイトにチャンク番号、前 8 バイトにノンスを XOR したもの
+// (7 バイト目は使いみち: データは 0、ダイジェストのマスクは 1、ストリームの終わりは 2。ノンスの下位 8 ビットは 0)
+static inline void chunk_iv(const container_t *header, uint64_t index, uint64_t nonce, uint8_t *iv) {
+	int i;
+
+	memcpy(iv, header->iv, 16);
+	for (i=0; i<8; ++i) {
+		iv[i] ^= (uint8_t)(nonce >> (56 - 8 * i));
+		iv[8 + i] ^= (uint8_t)(index >> (56 - 8 * i));
+	}
+}
+
+
+// 索引を読む (buf は CONTAINER_INDEX_SIZE バイト)
+static inline void read_index(const uint8_t *buf, index_t *index) {
+	int i;
+
+	index->generation = ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+	index->nonce = 0;
+	index->digest = 0;
+	for (i=0; i<8; ++i) {
+		index->nonce = (index->nonce << 8) | buf[4 + i];
+		index->digest = (index->digest << 8) | buf[12 + i];
+	}
+}
+
+// 索引を書く (CONTAINER_INDEX_SIZE バイト)
+static inline void write_index(uint8_t *buf, const index_t *index) {
+	int i;
+
+	for (i=0; i<4; ++i) {
+		buf[i] = (uint8_t)(index->generation >> (24 - 8 * i));
+	}
+	for (i=0; i<8; ++i) {
+		buf[4 + i] = (uint8_t)(index->nonce >> (56 - 8 * i));
+		buf[12 + i] = (uint8_t)(index->digest >> (56 - 8 * i));
+	}
+}
+
+
+// チャンクのダイジェスト: FNV-1a (64 ビット) を 8 バイト (リトルエンディアン) ずつ回したもの。
+// 端数は 1 バイトずつ。暗号学的なものではなく、変わったチャンクを見つけるためのもの。
+static inline uint64_t chunk_digest(const uint8_t *buf, size_t len) {
+	uint64_t h = 0xcbf29ce484222325ull, w;
+	size_t i;
+	int j;
+
+	for (i=0; i+8<=len; i+=8) {
+		w = 0;
+		for (j=7; j>=0; --j) {
+			w = (w << 8) | buf[i + j];
+		}
+		h = (h ^ w) * 0x100000001b3ull;
+	}
+	for (; i<len; ++i) {
+		h = (h ^ buf[i]) * 0x100000001b3ull;
+	}
+	return h;
+}
+
+// ダイジェストのマスク: 使いみち 1 の IV でつくった鍵ストリームの先頭 8 バイト。
+// 同じ内容のチャンクが同じダイジェストにならないように、索引にはマスクして書く。
+static inline uint64_t chunk_mask(CRYPTK2 k2, CRYPTK2_KEY key, const container_t *header, uint64_t index, uint64_t nonce) {
+	uint8_t iv[16], buf[8];
+	uint64_t mask = 0;
+	int i;
+
+	chunk_iv(header, index, nonce, iv);
+	iv[7] ^= 1;
+	cryptk2_setup_iv(k2, key, iv);
+	cryptk2_stream(k2, 8, buf);
+	for (i=0; i<8; ++i) {
+		mask = (mask << 8) | buf[i];
+	}
+	return mask;
+}
+
+// ストリームの終わり: 暗号化前のファイルサイズと、それを使いみち 2 の鍵ストリームでマスクしたもの
+static inline void stream_footer(CRYPTK2 k2, CRYPTK2_KEY key, const container_t *header, uint64_t size, uint8_t *buf) {
+	uint8_t iv[16], mask[8];
+	int i;
+
+	chunk_iv(header, 0, 0, iv);
+	iv[7] ^= 2;
+	cryptk2_setup_iv(k2, key, iv);
+	cryptk2_stream(k2, 8, mask);
+	for (i=0; i<8; ++i) {
+		buf[i] = (uint8_t)(size >> (56 - 8 * i));
+		buf[8 + i] = buf[i] ^ mask[i];
+	}
+}
+
+#endif
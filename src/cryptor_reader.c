@@ -0,0 +1,159 @@
+/**
+ *  CryptK2 Library - KCipher-2(R) Implementation for C/C++
+ *  Copyright (c) 2015-2022 Mystia.org Project. All rights reserved.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cryptor_reader.h"
+#include "cryptor_format.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+// an opened file
+struct _cryptor_reader {
+	FILE *file;
+	CRYPTK2_KEY keyctx;
+	CRYPTK2 state;
+	container_t header;  // v1 files keep their iv in header.iv
+	int v2;
+	uint64_t data;       // offset of the first encrypted byte
+};
+
+
+// open an encrypted file with its key
+CRYPTOR CRYPTK2_API cryptor_open(const char *filename, const uint8_t *key) {
+	CRYPTOR handle;
+	int64_t size;
+
+	// validate arguments
+	if (filename == NULL || key == NULL) {
+		return NULL;
+	}
+
+	// allocate memory
+	handle = (CRYPTOR)malloc(sizeof(struct _cryptor_reader));
+	if (handle == NULL) {
+		return NULL;
+	}
+	handle->keyctx = cryptk2_key_new();
+	handle->state = new_cryptk2();
+	handle->file = fopen(filename, "rb");
+	if (handle->keyctx == NULL || handle->state == NULL || handle->file == NULL) {
+		goto failed;
+	}
+	cryptk2_key_expand(handle->keyctx, key);
+
+	// the size tells v1 from v2, as in cryptor
+	if (fseek64(handle->file, 0, SEEK_END) || (size = ftell64(handle->file)) < 16 || fseek64(handle->file, 0, SEEK_SET)) {
+		goto failed;
+	}
+	handle->v2 = read_header(handle->file, (uint64_t)size, &handle->header);
+	if (handle->v2 < 0) {
+		goto failed;
+	}
+	if (handle->v2) {
+		handle->data = CONTAINER_HEADER_SIZE;
+	}
+	else {
+		// v1: the iv and one stream
+		if (fseek64(handle->file, 0, SEEK_SET) || fread(handle->header.iv, 1, 16, handle->file) != 16) {
+			goto failed;
+		}
+		handle->header.size = (uint64_t)size - 16;
+		handle->data = 16;
+	}
+
+	return handle;
+
+failed:
+	cryptor_close(handle);
+	return NULL;
+}
+
+// decrypt len bytes at offset of the plain text into buf.
+// returns the bytes read (short at the end of the file), or -1 on a read error.
+int64_t CRYPTK2_API cryptor_pread(CRYPTOR handle, uint64_t offset, size_t len, uint8_t *buf) {
+	uint64_t index, done;
+	size_t first, n;
+	uint8_t iv[16], record[CONTAINER_INDEX_SIZE];
+	index_t entry;
+
+	// validate arguments
+	if (handle == NULL || buf == NULL) {
+		return -1;
+	}
+	if (offset >= handle->header.size || len == 0) {
+		return 0;
+	}
+	if (len > handle->header.size - offset) {
+		len = (size_t)(handle->header.size - offset);
+	}
+
+	// the encrypted bytes straight into buf, decrypted in place
+	if (fseek64(handle->file, (int64_t)(handle->data + offset), SEEK_SET) || fread(buf, 1, len, handle->file) != len) {
+		return -1;
+	}
+
+	if (!handle->v2) {
+		// v1: one stream from the beginning of the file
+		cryptk2_setup_iv(handle->state, handle->keyctx, handle->header.iv);
+		cryptk2_skip(handle->state, offset);
+		cryptk2_crypt(handle->state, len, buf, buf);
+		return (int64_t)len;
+	}
+
+	// v2: each chunk from its own iv, skipped to the first byte wanted
+	for (done=0; done<len; done+=n) {
+		index = (offset + done) / handle->header.chunk_size;
+		first = (size_t)((offset + done) % handle->header.chunk_size);
+		n = handle->header.chunk_size - first;
+		if (n > len - done) {
+			n = (size_t)(len - done);
+		}
+
+		// a chunk rewritten by an update has its nonce in the index
+		entry.nonce = 0;
+		if (handle->header.flags & CONTAINER_FLAG_INDEX) {
+			if (fseek64(handle->file, (int64_t)(index_offset(&handle->header) + index * CONTAINER_INDEX_SIZE), SEEK_SET) || fread(record, 1, CONTAINER_INDEX_SIZE, handle->file) != CONTAINER_INDEX_SIZE) {
+				return -1;
+			}
+			read_index(record, &entry);
+		}
+
+		chunk_iv(&handle->header, index, entry.nonce, iv);
+		cryptk2_setup_iv(handle->state, handle->keyctx, iv);
+		cryptk2_skip(handle->state, first);
+		cryptk2_crypt(handle->state, n, buf + done, buf + done);
+	}
+
+	return (int64_t)len;
+}
+
+// bytes of the plain text
+uint64_t CRYPTK2_API cryptor_size(CRYPTOR handle) {
+	return (handle != NULL) ? handle->header.size : 0;
+}
+
+// close an encrypted file
+void CRYPTK2_API cryptor_close(CRYPTOR handle) {
+	if (handle != NULL) {
+		if (handle->file != NULL) {
+			fclose(handle->file);
+		}
+		cryptk2_key_delete(handle->keyctx);
+		delete_cryptk2(handle->state);
+
+		// clear from memory
+		memset(handle, 0, sizeof(struct _cryptor_reader));
+		free(handle);
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
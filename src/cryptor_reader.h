@@ -0,0 +1,32 @@
+/**
+ *  CryptK2 Library - KCipher-2(R) Implementation for C/C++
+ *  Copyright (c) 2015-2022 Mystia.org Project. All rights reserved.
+ */
+
+#ifndef LIBCRYPTK2_CRYPTOR_READER_H_
+#define LIBCRYPTK2_CRYPTOR_READER_H_
+
+// for CRYPTK2_API, size_t and uint8_t
+#include "cryptk2.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// random access to files encrypted by cryptor. chunked (v2) files set up only the chunks
+// which are read; legacy (v1) files skip the stream up to the offset.
+// a handle must not be used by two threads at once.
+typedef struct _cryptor_reader *CRYPTOR;
+
+CRYPTOR CRYPTK2_API cryptor_open(const char *filename, const uint8_t *key);
+int64_t CRYPTK2_API cryptor_pread(CRYPTOR handle, uint64_t offset, size_t len, uint8_t *buf);
+uint64_t CRYPTK2_API cryptor_size(CRYPTOR handle);
+void CRYPTK2_API cryptor_close(CRYPTOR handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,4 +1,4 @@
-#define CRYPTOR_VER_MAJOR 0
-#define CRYPTOR_VER_MINOR 1
-#define CRYPTOR_VER_REVISION 4
-#define CRYPTOR_VER_BUILD 0
+#define CRYPTOR_VER_MAJOR 0
+#define CRYPTOR_VER_MINOR 2
+#define CRYPTOR_VER_REVISION 0
+#define CRYPTOR_VER_BUILD 0